@@ -0,0 +1,97 @@
+#include "Benchmark.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include "SDL_thread.h"
+
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+#include "Core/Memory/SmallObjectPool.hpp"
+#include "Core/Memory/TlsfAllocator.hpp"
+
+static const size_t MaxThreadCount = 8;
+
+static const size_t RoundCount = 2000;
+static const size_t BatchSize = 256;
+
+static const size_t PoolSize = 16 * 1024 * 1024;
+
+// Largest object SmallObjectPool serves
+static const size_t MaxObjectSize = 128;
+
+// Every thread allocates a batch of objects of String and Delegate sizes,
+// writes to them and frees them in a different order
+template <typename Allocator>
+struct AllocationRun {
+    Allocator& alloc;
+    std::atomic<bool> go;
+
+    explicit AllocationRun(Allocator& alloc) :
+        alloc(alloc), //XXX: gcc bug prevents from using brace initialization syntax
+        go {false}
+    {}
+
+    static int run(void* data) {
+        auto self = static_cast<AllocationRun*>(data);
+        while (!self->go.load(std::memory_order_acquire))
+            std::this_thread::yield();
+
+        void* objects[BatchSize];
+        uint64_t seed = reinterpret_cast<uintptr_t>(&objects);
+
+        for (size_t round = 0; round < RoundCount; ++round) {
+            for (size_t i = 0; i < BatchSize; ++i) {
+                seed = benchmark::spin(1, seed);
+                const size_t size = 16 + (seed >> 33) % (MaxObjectSize - 16 + 1);
+
+                objects[i] = self->alloc.allocate(size, sizeof(void*), 0);
+                *static_cast<uint64_t*>(objects[i]) = seed;
+            }
+
+            // odd objects first, so frees don't just mirror allocations
+            for (size_t i = 1; i < BatchSize; i += 2)
+                self->alloc.free(objects[i]);
+            for (size_t i = 0; i < BatchSize; i += 2)
+                self->alloc.free(objects[i]);
+        }
+
+        SmallObjectPool::releaseThreadCache();
+        return 0;
+    }
+};
+
+template <typename Allocator>
+static void measure(Allocator& alloc, const char* const allocatorName, const size_t threadCount) {
+    AllocationRun<Allocator> run(alloc);
+
+    SDL_Thread* threads[MaxThreadCount];
+    for (size_t i = 0; i < threadCount; ++i)
+        threads[i] = SDL_CreateThread(&AllocationRun<Allocator>::run, "Allocation benchmark", &run);
+
+    const uint64_t start = benchmark::ticks();
+    run.go.store(true, std::memory_order_release);
+
+    for (size_t i = 0; i < threadCount; ++i)
+        SDL_WaitThread(threads[i], nullptr);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s, %u thread(s)", allocatorName, static_cast<unsigned>(threadCount));
+
+    // allocate+free pairs of all threads together
+    benchmark::report(name, benchmark::ticks() - start, threadCount * RoundCount * BatchSize);
+}
+
+// SmallObjectPool with per-thread caches against TLSF behind a single lock
+void benchmarkAllocation(LinearAllocator& alloc) {
+    ScopeStack<LinearAllocator> scope(alloc, "Allocation benchmark");
+
+    SmallObjectPool* const pool = scope.create<SmallObjectPool>(scope, PoolSize, "Benchmark pool");
+    TlsfAllocator* const tlsf = scope.create<TlsfAllocator>(scope, PoolSize, "Benchmark TLSF");
+
+    for (size_t threadCount = 1; threadCount <= MaxThreadCount; threadCount *= 2) {
+        measure(*pool, "SmallObjectPool", threadCount);
+        measure(*tlsf, "TlsfAllocator", threadCount);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef Benchmark_h__
+#define Benchmark_h__
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include "SDL_log.h"
+#include "SDL_timer.h"
+
+class LinearAllocator;
+
+// Helpers shared by benchmark suites. Suites take their memory from the given allocator,
+// it is rewound after every suite. Results are printed with SDL_Log
+namespace benchmark {
+
+    extern std::atomic<uint64_t> sink;
+
+    // Keeps the compiler from dropping the measured work. Threads almost never
+    // write the sink, so they don't fight over its cache line
+    inline void consume(const uint64_t value) {
+        if (value == 0)
+            sink.store(value, std::memory_order_relaxed);
+    }
+
+    inline uint64_t ticks() {
+        return SDL_GetPerformanceCounter();
+    }
+
+    inline double nanoseconds(const uint64_t ticks) {
+        return static_cast<double>(ticks) * 1000000000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    }
+
+    inline void report(const char* const name, const uint64_t ticks, const size_t operationCount) {
+        SDL_Log("  %-48s %12.1f ns/op %14.0f op/s",
+                name,
+                nanoseconds(ticks) / static_cast<double>(operationCount),
+                static_cast<double>(operationCount) * 1000000000.0 / nanoseconds(ticks));
+    }
+
+    // Busy work of roughly fixed cost which can't be optimized out
+    inline uint64_t spin(const size_t iterations, uint64_t seed) {
+        for (size_t i = 0; i < iterations; ++i)
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        return seed;
+    }
+
+}
+
+void benchmarkAllocation(LinearAllocator& alloc);
+void benchmarkChurn(LinearAllocator& alloc);
+void benchmarkJob(LinearAllocator& alloc);
+void benchmarkJobQueue(LinearAllocator& alloc);
+void benchmarkParallelFor(LinearAllocator& alloc);
+void benchmarkProfiler(LinearAllocator& alloc);
+void benchmarkRegistry(LinearAllocator& alloc);
+void benchmarkSlotMap(LinearAllocator& alloc);
+void benchmarkTlsf(LinearAllocator& alloc);
+
+#endif // Benchmark_h__
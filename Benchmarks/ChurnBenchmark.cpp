@@ -0,0 +1,113 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+
+#include "Core/Delegate.hpp"
+#include "Core/String.hpp"
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/SmallObjectPool.hpp"
+
+static const size_t LiveCount = 4096;
+static const size_t ReplaceCount = 1000000;
+
+// usedSize is sampled that often to find the peak
+static const size_t SampleInterval = 1024;
+
+static const size_t MaxStringLength = 100;
+
+typedef Delegate<uint64_t ()> Callback;
+
+// Functors are too big to be stored inside a delegate, so every one takes a pool chunk
+// of two to four words
+static size_t callbackSize(const uint64_t seed) {
+    return (2 + seed % 3) * sizeof(uint64_t);
+}
+
+static Callback makeCallback(const uint64_t seed) {
+    const uint64_t a = seed, b = seed >> 7, c = seed >> 13, d = seed >> 29;
+
+    switch (seed % 3) {
+    case 0:
+        return Callback::create([a, b]{ return a + b; });
+    case 1:
+        return Callback::create([a, b, c]{ return a + b + c; });
+    default:
+        return Callback::create([a, b, c, d]{ return a + b + c + d; });
+    }
+}
+
+template <typename T>
+static T* createArray(LinearAllocator& alloc, const size_t count) {
+    T* const array = static_cast<T*>(alloc.allocate(count * sizeof(T), std::alignment_of<T>::value, 0));
+    for (size_t i = 0; i < count; ++i)
+        new (&array[i]) T();
+    return array;
+}
+
+static String makeString(const uint64_t seed, const size_t length) {
+    char buffer[MaxStringLength];
+    std::fill_n(buffer, length, static_cast<char>('a' + seed % 26));
+    return String(buffer, length);
+}
+
+// Replaces random strings and delegates of a live set, as UI labels and
+// event handlers do, and checks how much pool memory it takes
+void benchmarkChurn(LinearAllocator& alloc) {
+    SmallObjectPool& pool = SmallObjectPool::getDefault();
+    const size_t usedBefore = pool.usedSize();
+    const size_t committedBefore = pool.committedSize();
+
+    String* const strings = createArray<String>(alloc, LiveCount);
+    Callback* const callbacks = createArray<Callback>(alloc, LiveCount);
+    size_t* const callbackSizes = createArray<size_t>(alloc, LiveCount);
+
+    uint64_t seed = 1;
+    size_t peak = 0;
+
+    const uint64_t start = benchmark::ticks();
+    for (size_t i = 0; i < ReplaceCount; ++i) {
+        seed = benchmark::spin(1, seed);
+        const size_t index = (seed >> 33) % LiveCount;
+
+        strings[index] = makeString(seed, 1 + (seed >> 17) % MaxStringLength);
+        callbacks[index] = makeCallback(seed >> 21);
+        callbackSizes[index] = callbackSize(seed >> 21);
+
+        if (i % SampleInterval == 0)
+            peak = std::max(peak, pool.usedSize());
+    }
+    benchmark::report("replace a string and a delegate", benchmark::ticks() - start, ReplaceCount);
+
+    // bytes asked for by live objects, string headers included
+    size_t payload = 0;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < LiveCount; ++i) {
+        payload += strings[i].size() + 1 + 2 * sizeof(uint16_t) + callbackSizes[i];
+        sum += callbacks[i].invoke();
+    }
+    benchmark::consume(sum);
+
+    const size_t used = pool.usedSize() - usedBefore;
+    SDL_Log("  %u live strings and delegates, %.1f KB requested",
+            static_cast<unsigned>(LiveCount), static_cast<double>(payload) / 1024.0);
+    SDL_Log("  pool slabs: %.1f KB at the end, %.1f KB at peak",
+            static_cast<double>(used) / 1024.0, static_cast<double>(peak - usedBefore) / 1024.0);
+
+    for (size_t i = 0; i < LiveCount; ++i) {
+        strings[i].~String();
+        callbacks[i].~Callback();
+    }
+    SmallObjectPool::releaseThreadCache();
+
+    // magazines parked in the bins keep their slabs until they are reused or trimmed
+    SDL_Log("  pool slabs after freeing everything: %.1f KB, %.1f KB committed",
+            static_cast<double>(pool.usedSize() - usedBefore) / 1024.0,
+            static_cast<double>(pool.committedSize() - committedBefore) / 1024.0);
+
+    pool.trim();
+    SDL_Log("  pool slabs after trimming: %.1f KB, %.1f KB committed",
+            static_cast<double>(pool.usedSize() - usedBefore) / 1024.0,
+            static_cast<double>(pool.committedSize() - committedBefore) / 1024.0);
+}
@@ -0,0 +1,86 @@
+#include "Benchmark.hpp"
+
+#include <new>
+#include <type_traits>
+
+#include "Core/Concurrency/Job.hpp"
+#include "Core/Concurrency/JobCounter.hpp"
+#include "Core/Concurrency/JobQueue.hpp"
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+#include "Core/Memory/SmallObjectPool.hpp"
+
+static const size_t DirectJobCount = 2000000;
+static const size_t QueuedJobCount = 200000;
+
+// Same shape as the atlas loader context
+struct Context {
+    uint64_t hash;
+    const char* path;
+    void* texture;
+};
+
+static void consumeContext(const Context& context) {
+    benchmark::consume(context.hash + reinterpret_cast<uintptr_t>(context.path) + reinterpret_cast<uintptr_t>(context.texture));
+}
+
+// How jobs passed their data before they had inline payloads
+static void pooledJob(void* payload) {
+    auto context = static_cast<Context*>(payload);
+    consumeContext(*context);
+
+    context->~Context();
+    SmallObjectPool::getDefault().free(context);
+}
+
+static Job makePooledJob(const uint64_t hash) {
+    void* const memory =
+        SmallObjectPool::getDefault().allocate(sizeof(Context), std::alignment_of<Context>::value, 0);
+    Context* const context = new (memory) Context {hash, "atlas", nullptr};
+    return Job(&pooledJob, context);
+}
+
+static Job makeInlineJob(const uint64_t hash) {
+    const Context context = {hash, "atlas", nullptr};
+    return Job::create([context]{ consumeContext(context); });
+}
+
+// Creates and runs jobs on the calling thread, only the payload handling is measured
+template <typename MakeJob>
+static void measureDirect(const char* const name, MakeJob makeJob) {
+    const uint64_t start = benchmark::ticks();
+    for (size_t i = 0; i < DirectJobCount; ++i) {
+        Job job = makeJob(i + 1);
+        job.run();
+    }
+
+    benchmark::report(name, benchmark::ticks() - start, DirectJobCount);
+}
+
+// Full submit+run round trip, the pool chunk is allocated by the main thread
+// and freed by whichever thread runs the job
+template <typename MakeJob>
+static void measureQueued(JobQueue& queue, const char* const name, MakeJob makeJob) {
+    JobCounter counter;
+
+    const uint64_t start = benchmark::ticks();
+    for (size_t i = 0; i < QueuedJobCount; ++i)
+        queue.add(makeJob(i + 1), counter);
+    queue.wait(counter);
+
+    benchmark::report(name, benchmark::ticks() - start, QueuedJobCount);
+}
+
+// Compares jobs carrying their data inline with jobs pointing to a SmallObjectPool chunk
+void benchmarkJob(LinearAllocator& alloc) {
+    measureDirect("create+run, pooled payload", &makePooledJob);
+    measureDirect("create+run, inline payload", &makeInlineJob);
+
+    ScopeStack<LinearAllocator> scope(alloc, "Job benchmark");
+    JobQueue* const queue = scope.create<JobQueue>(scope, 0);
+
+    SDL_Log(" %u worker(s) and the main thread", static_cast<unsigned>(queue->workerCount()));
+
+    measureQueued(*queue, "submit+run, pooled payload", &makePooledJob);
+    measureQueued(*queue, "submit+run, inline payload", &makeInlineJob);
+}
@@ -0,0 +1,92 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "Core/Concurrency/Job.hpp"
+#include "Core/Concurrency/JobCounter.hpp"
+#include "Core/Concurrency/JobQueue.hpp"
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+
+static const size_t EmptyJobCount = 200000;
+
+// Every work job takes about a microsecond
+static const size_t WorkJobCount = 50000;
+static const size_t WorkIterations = 1000;
+
+static const size_t HotLatencyJobCount = 2000;
+static const size_t IdleLatencyJobCount = 200;
+
+static void emptyJob(void*) {
+}
+
+static void workJob(void* payload) {
+    benchmark::consume(benchmark::spin(WorkIterations, reinterpret_cast<uintptr_t>(payload)));
+}
+
+static void markStart(void* payload) {
+    static_cast<std::atomic<uint64_t>*>(payload)->store(benchmark::ticks(), std::memory_order_release);
+}
+
+// Main thread submits all jobs and helps running them while it waits
+static void measureThroughput(JobQueue& queue, const char* const name, const Job& job, const size_t count) {
+    JobCounter counter;
+
+    const uint64_t start = benchmark::ticks();
+    for (size_t i = 0; i < count; ++i)
+        queue.add(job, counter);
+    queue.wait(counter);
+
+    benchmark::report(name, benchmark::ticks() - start, count);
+}
+
+// Time from adding a job to a worker starting it. The main thread doesn't help,
+// with idle set workers are given time to park before every job
+static void measureLatency(JobQueue& queue, const char* const name, const size_t count, const bool idle) {
+    uint64_t totalTicks = 0;
+    uint64_t maxTicks = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (idle)
+            SDL_Delay(1);
+
+        std::atomic<uint64_t> started {0};
+        JobCounter counter;
+
+        const uint64_t submitted = benchmark::ticks();
+        queue.add(Job(&markStart, &started), counter);
+        while (!counter.done())
+            std::this_thread::yield();
+
+        const uint64_t latency = started.load(std::memory_order_acquire) - submitted;
+        totalTicks += latency;
+        maxTicks = std::max(maxTicks, latency);
+    }
+
+    SDL_Log("  %-48s avg %10.2f us   max %10.2f us",
+            name,
+            benchmark::nanoseconds(totalTicks) / 1000.0 / static_cast<double>(count),
+            benchmark::nanoseconds(maxTicks) / 1000.0);
+}
+
+static void run(LinearAllocator& alloc, const size_t workerCount) {
+    ScopeStack<LinearAllocator> scope(alloc, "JobQueue benchmark");
+    JobQueue* const queue = scope.create<JobQueue>(scope, workerCount);
+
+    SDL_Log(" %u worker(s) and the main thread", static_cast<unsigned>(queue->workerCount()));
+
+    measureThroughput(*queue, "empty jobs", Job(&emptyJob), EmptyJobCount);
+    measureThroughput(*queue, "1us jobs", Job(&workJob), WorkJobCount);
+
+    measureLatency(*queue, "latency, busy workers", HotLatencyJobCount, false);
+    measureLatency(*queue, "latency, parked workers", IdleLatencyJobCount, true);
+}
+
+// Single worker is how the queue ran before it got work stealing,
+// zero worker count spawns a worker per hardware thread
+void benchmarkJobQueue(LinearAllocator& alloc) {
+    run(alloc, 1);
+    run(alloc, 0);
+}
@@ -0,0 +1,79 @@
+#include "Benchmark.hpp"
+
+#include <cstdio>
+#include <type_traits>
+
+#include "Core/Concurrency/JobQueue.hpp"
+#include "Core/Concurrency/ParallelFor.hpp"
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+
+static const size_t ElementCount = 1 << 20;
+static const size_t RepeatCount = 8;
+
+// Light elements are about the cost of an animation clip update,
+// heavy ones make scheduling cost negligible
+static const size_t LightIterations = 16;
+static const size_t HeavyIterations = 256;
+
+static const size_t FineGrain = 64;
+
+static void measureSerial(uint64_t* const values, const char* const name, const size_t iterations) {
+    const uint64_t start = benchmark::ticks();
+    for (size_t repeat = 0; repeat < RepeatCount; ++repeat) {
+        for (size_t i = 0; i < ElementCount; ++i)
+            values[i] = benchmark::spin(iterations, values[i]);
+    }
+
+    benchmark::report(name, benchmark::ticks() - start, ElementCount * RepeatCount);
+}
+
+static void measureParallel(uint64_t* const values, const char* const name, const size_t iterations, const size_t grain) {
+    const uint64_t start = benchmark::ticks();
+    for (size_t repeat = 0; repeat < RepeatCount; ++repeat) {
+        parallel_for(0, ElementCount, grain, [=](const size_t from, const size_t to) {
+            for (size_t i = from; i < to; ++i)
+                values[i] = benchmark::spin(iterations, values[i]);
+        });
+    }
+
+    benchmark::report(name, benchmark::ticks() - start, ElementCount * RepeatCount);
+}
+
+// parallel_for always goes through the default queue, so it is recreated for every worker count
+static void run(LinearAllocator& alloc, uint64_t* const values, const size_t workerCount) {
+    ScopeStack<LinearAllocator> scope(alloc, "ParallelFor benchmark");
+    JobQueue::DefaultInstance jobQueue(scope, workerCount);
+
+    char name[64];
+    const unsigned threadCount = static_cast<unsigned>(JobQueue::getDefault().workerCount() + 1);
+
+    snprintf(name, sizeof(name), "%u thread(s), light, auto grain", threadCount);
+    measureParallel(values, name, LightIterations, 0);
+
+    snprintf(name, sizeof(name), "%u thread(s), light, grain %u", threadCount, static_cast<unsigned>(FineGrain));
+    measureParallel(values, name, LightIterations, FineGrain);
+
+    snprintf(name, sizeof(name), "%u thread(s), heavy, auto grain", threadCount);
+    measureParallel(values, name, HeavyIterations, 0);
+}
+
+// Compares a plain loop with parallel_for on one worker, a few workers
+// and a worker per hardware thread
+void benchmarkParallelFor(LinearAllocator& alloc) {
+    auto values = static_cast<uint64_t*>(alloc.allocate(ElementCount * sizeof(uint64_t), std::alignment_of<uint64_t>::value, 0));
+    for (size_t i = 0; i < ElementCount; ++i)
+        values[i] = i;
+
+    measureSerial(values, "serial loop, light", LightIterations);
+    measureSerial(values, "serial loop, heavy", HeavyIterations);
+
+    run(alloc, values, 1);
+    run(alloc, values, 3);
+    run(alloc, values, 0);
+
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < ElementCount; ++i)
+        checksum += values[i];
+    benchmark::consume(checksum);
+}
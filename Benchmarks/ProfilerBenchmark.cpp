@@ -0,0 +1,59 @@
+#include "Benchmark.hpp"
+
+#include "Core/Profiler.hpp"
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+
+static const size_t ZoneCount = 2000000;
+
+// Zones are opened directly rather than with PROFILE_ZONE,
+// so the cost is measured even when ENABLE_PROFILER is off
+static void measureZones(const char* const name, const size_t iterations) {
+    uint64_t seed = 1;
+
+    const uint64_t start = benchmark::ticks();
+    for (size_t i = 0; i < ZoneCount; ++i) {
+        const ProfileZone zone("benchmark zone");
+        seed = benchmark::spin(iterations, seed);
+    }
+
+    benchmark::report(name, benchmark::ticks() - start, ZoneCount);
+    benchmark::consume(seed);
+}
+
+// Every event reads the performance counter once
+static void measureCounter(const char* const name) {
+    uint64_t sum = 0;
+
+    const uint64_t start = benchmark::ticks();
+    for (size_t i = 0; i < ZoneCount; ++i)
+        sum += benchmark::ticks();
+
+    benchmark::report(name, benchmark::ticks() - start, ZoneCount);
+    benchmark::consume(sum);
+}
+
+static void measureBaseline(const char* const name, const size_t iterations) {
+    uint64_t seed = 1;
+
+    const uint64_t start = benchmark::ticks();
+    for (size_t i = 0; i < ZoneCount; ++i)
+        seed = benchmark::spin(iterations, seed);
+
+    benchmark::report(name, benchmark::ticks() - start, ZoneCount);
+    benchmark::consume(seed);
+}
+
+// Cost of a begin/end zone pair, with no profiler instance and with one recording
+void benchmarkProfiler(LinearAllocator& alloc) {
+    measureCounter("performance counter read");
+    measureBaseline("no zone, 100 iterations of work", 100);
+
+    measureZones("zone, profiler not created", 0);
+
+    ScopeStack<LinearAllocator> scope(alloc, "Profiler benchmark");
+    Profiler::DefaultInstance profiler(scope);
+
+    measureZones("zone, profiler recording", 0);
+    measureZones("zone, profiler recording, 100 iterations of work", 100);
+}
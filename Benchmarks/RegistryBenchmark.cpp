@@ -0,0 +1,123 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#include "Core/ClipRegistry.hpp"
+#include "Core/SpriteRegistry.hpp"
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+#include "Util/Registry.hpp"
+
+static const size_t LookupCount = 4000000;
+
+// The registry as it was before the hash index: entries sorted by name hash,
+// found with binary search and inserted with std::rotate
+template <typename T, size_t Size>
+class SortedRegistry {
+    struct Entry {
+        uint32_t nameHash;
+        const T* resource;
+
+        bool operator <(const Entry& other) const {
+            return nameHash < other.nameHash;
+        }
+    };
+
+    Entry* const _entries;
+    size_t _entryCount;
+
+    Entry* entryForHash(const uint32_t nameHash) const {
+        const Entry value = {nameHash, nullptr};
+        return std::lower_bound(_entries, _entries + _entryCount, value);
+    }
+
+public:
+    template <typename Allocator>
+    explicit SortedRegistry(Allocator& alloc) :
+        _entries {static_cast<Entry*>(alloc.allocate(Size * sizeof(Entry), std::alignment_of<Entry>::value, 0))},
+        _entryCount {0}
+    {}
+
+    void registerResource(const uint32_t nameHash, const T* resource) {
+        assert(("Maximum resource count reached", _entryCount < Size));
+
+        auto pos = entryForHash(nameHash);
+        auto end = _entries + _entryCount;
+        std::rotate(pos, end, end + 1);
+
+        const Entry value = {nameHash, resource};
+        *pos = value;
+
+        ++_entryCount;
+    }
+
+    const T* resourceForHandle(const uint32_t nameHash) const {
+        auto entry = entryForHash(nameHash);
+        assert(("No resource found", entry != _entries + _entryCount));
+
+        return entry->resource;
+    }
+};
+
+// Murmur3 finalizer, distinct inputs give distinct name hashes
+static uint32_t nameHash(uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x85ebca6bu;
+    value ^= value >> 13;
+    value *= 0xc2b2ae35u;
+    value ^= value >> 16;
+    return value;
+}
+
+static void report(const char* const container, const char* const operation, const size_t count,
+                   const uint64_t ticks, const size_t operationCount) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s<%u> %s", container, static_cast<unsigned>(count), operation);
+    benchmark::report(name, ticks, operationCount);
+}
+
+// Registers resources one at a time, as loaders do, then looks them up in random order
+template <typename Registry, size_t Count>
+static void measure(ScopeStack<LinearAllocator>& scope, const char* const registryName,
+                    const uint32_t* const hashes, const uint32_t* const values) {
+    auto registry = scope.create<Registry>(scope);
+
+    uint64_t start = benchmark::ticks();
+    for (size_t i = 0; i < Count; ++i)
+        registry->registerResource(hashes[i], &values[i]);
+    report(registryName, "insert", Count, benchmark::ticks() - start, Count);
+
+    uint64_t seed = Count;
+    uint64_t sum = 0;
+    start = benchmark::ticks();
+    for (size_t i = 0; i < LookupCount; ++i) {
+        seed = benchmark::spin(1, seed);
+        sum += *registry->resourceForHandle(hashes[(seed >> 33) % Count]);
+    }
+    report(registryName, "lookup", Count, benchmark::ticks() - start, LookupCount);
+
+    benchmark::consume(sum);
+}
+
+template <size_t Count>
+static void measure(LinearAllocator& alloc) {
+    ScopeStack<LinearAllocator> scope(alloc, "Registry benchmark");
+
+    uint32_t* const values = scope.createPODArray<uint32_t>(Count);
+    uint32_t* const hashes = scope.createPODArray<uint32_t>(Count);
+    for (size_t i = 0; i < Count; ++i) {
+        values[i] = static_cast<uint32_t>(i);
+        hashes[i] = nameHash(static_cast<uint32_t>(i));
+    }
+
+    measure<SortedRegistry<uint32_t, Count>, Count>(scope, "Sorted array", hashes, values);
+    measure<util::Registry<uint32_t, Count>, Count>(scope, "Robin Hood", hashes, values);
+}
+
+// At the capacities of the sprite and clip registries
+void benchmarkRegistry(LinearAllocator& alloc) {
+    measure<MaxSpriteCount>(alloc);
+    measure<MaxClipCount>(alloc);
+}
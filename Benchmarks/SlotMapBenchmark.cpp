@@ -0,0 +1,108 @@
+#include "Benchmark.hpp"
+
+#include <cstdio>
+#include <utility>
+
+#include "Core/ClipRegistry.hpp"
+#include "Core/SpriteRegistry.hpp"
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+#include "Util/Registry.hpp"
+#include "Util/SlotMap.hpp"
+
+static const size_t LookupCount = 4000000;
+
+// Murmur3 finalizer, distinct inputs give distinct name hashes
+static uint32_t nameHash(uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x85ebca6bu;
+    value ^= value >> 13;
+    value *= 0xc2b2ae35u;
+    value ^= value >> 16;
+    return value;
+}
+
+// Random order, so lookups don't walk the tables linearly
+static void shuffle(uint32_t* const order, const size_t count) {
+    uint64_t seed = count;
+    for (size_t i = 0; i < count; ++i)
+        order[i] = static_cast<uint32_t>(i);
+
+    for (size_t i = count - 1; i > 0; --i) {
+        seed = benchmark::spin(1, seed);
+        std::swap(order[i], order[(seed >> 33) % (i + 1)]);
+    }
+}
+
+static void report(const char* const container, const char* const operation, const size_t count,
+                   const uint64_t ticks, const size_t operationCount) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s<%u> %s", container, static_cast<unsigned>(count), operation);
+    benchmark::report(name, ticks, operationCount);
+}
+
+// Items are looked up by SlotMap handles and by Registry name hashes, which is
+// how systems find their resources today
+template <size_t Count>
+static void measure(LinearAllocator& alloc) {
+    ScopeStack<LinearAllocator> scope(alloc, "SlotMap benchmark");
+
+    uint32_t* const values = scope.createPODArray<uint32_t>(Count);
+    uint32_t* const hashes = scope.createPODArray<uint32_t>(Count);
+    uint32_t* const order = scope.createPODArray<uint32_t>(Count);
+    util::SlotHandle* const handles = scope.createPODArray<util::SlotHandle>(Count);
+
+    for (size_t i = 0; i < Count; ++i) {
+        values[i] = static_cast<uint32_t>(i);
+        hashes[i] = nameHash(static_cast<uint32_t>(i));
+    }
+    shuffle(order, Count);
+
+    auto slotMap = scope.create<util::SlotMap<uint32_t>>(scope, Count);
+    auto registry = scope.create<util::Registry<uint32_t, Count>>(scope);
+
+    uint64_t start = benchmark::ticks();
+    for (size_t i = 0; i < Count; ++i)
+        handles[i] = slotMap->insert(values[i]);
+    report("SlotMap", "insert", Count, benchmark::ticks() - start, Count);
+
+    start = benchmark::ticks();
+    for (size_t i = 0; i < Count; ++i)
+        registry->registerResource(hashes[i], &values[i]);
+    report("Registry", "insert", Count, benchmark::ticks() - start, Count);
+
+    uint64_t sum = 0;
+    start = benchmark::ticks();
+    for (size_t i = 0; i < LookupCount; ++i)
+        sum += slotMap->get(handles[order[i % Count]]);
+    report("SlotMap", "lookup", Count, benchmark::ticks() - start, LookupCount);
+
+    start = benchmark::ticks();
+    for (size_t i = 0; i < LookupCount; ++i)
+        sum += *registry->resourceForHandle(hashes[order[i % Count]]);
+    report("Registry", "lookup", Count, benchmark::ticks() - start, LookupCount);
+
+    // dense iteration is what SlotMap offers on top of lookups
+    start = benchmark::ticks();
+    for (const uint32_t value : *slotMap)
+        sum += value;
+    report("SlotMap", "iterate", Count, benchmark::ticks() - start, Count);
+
+    start = benchmark::ticks();
+    for (size_t i = 0; i < Count; ++i)
+        slotMap->erase(handles[order[i]]);
+    report("SlotMap", "erase", Count, benchmark::ticks() - start, Count);
+
+    start = benchmark::ticks();
+    for (size_t i = 0; i < Count; ++i)
+        registry->unregisterResource(hashes[order[i]]);
+    report("Registry", "erase", Count, benchmark::ticks() - start, Count);
+
+    benchmark::consume(sum);
+}
+
+// At the capacities of the sprite and clip registries
+void benchmarkSlotMap(LinearAllocator& alloc) {
+    measure<MaxSpriteCount>(alloc);
+    measure<MaxClipCount>(alloc);
+}
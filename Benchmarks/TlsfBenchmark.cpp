@@ -0,0 +1,92 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+#include "Core/Memory/TlsfAllocator.hpp"
+
+static const size_t ReserveSize = 256 * 1024 * 1024;
+
+static const size_t LiveCount = 4096;
+static const size_t ChurnCount = 1000000;
+
+// Mostly small buffers with an occasional decode buffer of a whole atlas
+static const size_t MaxSmallSize = 16 * 1024;
+static const size_t LargeSize = 1024 * 1024;
+static const size_t LargeEvery = 256;
+
+static size_t blockSize(const uint64_t seed) {
+    if ((seed >> 40) % LargeEvery == 0)
+        return LargeSize + (seed >> 20) % LargeSize;
+    return 16 + (seed >> 33) % MaxSmallSize;
+}
+
+// Replaces random live blocks, timing every allocate and free on its own to find the worst case.
+// Averages include the cost of reading the performance counter
+void benchmarkTlsf(LinearAllocator& alloc) {
+    ScopeStack<LinearAllocator> scope(alloc, "TLSF benchmark");
+    TlsfAllocator* const heap = scope.create<TlsfAllocator>(ReserveSize, VirtualMemory::NormalPages, "Benchmark TLSF");
+
+    void** const blocks = scope.createPODArray<void*>(LiveCount);
+    size_t* const sizes = scope.createPODArray<size_t>(LiveCount);
+
+    uint64_t seed = 1;
+    size_t requested = 0;
+    for (size_t i = 0; i < LiveCount; ++i) {
+        seed = benchmark::spin(1, seed);
+        sizes[i] = blockSize(seed);
+        blocks[i] = heap->allocate(sizes[i], 16, 0);
+        requested += sizes[i];
+    }
+
+    uint64_t allocateTicks = 0, freeTicks = 0;
+    uint64_t maxAllocateTicks = 0, maxFreeTicks = 0;
+    size_t failedCount = 0;
+    size_t peakRequested = requested;
+
+    for (size_t i = 0; i < ChurnCount; ++i) {
+        seed = benchmark::spin(1, seed);
+        const size_t index = (seed >> 45) % LiveCount;
+
+        uint64_t start = benchmark::ticks();
+        heap->free(blocks[index]);
+        uint64_t ticks = benchmark::ticks() - start;
+        freeTicks += ticks;
+        maxFreeTicks = std::max(maxFreeTicks, ticks);
+        requested -= sizes[index];
+
+        sizes[index] = blockSize(seed);
+
+        start = benchmark::ticks();
+        blocks[index] = heap->allocate(sizes[index], 16, 0);
+        ticks = benchmark::ticks() - start;
+        allocateTicks += ticks;
+        maxAllocateTicks = std::max(maxAllocateTicks, ticks);
+
+        if (blocks[index]) {
+            requested += sizes[index];
+            peakRequested = std::max(peakRequested, requested);
+        } else {
+            sizes[index] = 0;
+            ++failedCount;
+        }
+    }
+
+    benchmark::report("allocate", allocateTicks, ChurnCount);
+    benchmark::report("free", freeTicks, ChurnCount);
+    SDL_Log("  %-48s allocate %8.2f us   free %8.2f us", "worst case",
+            benchmark::nanoseconds(maxAllocateTicks) / 1000.0, benchmark::nanoseconds(maxFreeTicks) / 1000.0);
+
+    // fragmentation shows up as committed memory the live blocks can't use
+    SDL_Log("  %.1f MB requested at peak, %.1f MB in blocks now, %.1f MB committed, %u failed allocations",
+            static_cast<double>(peakRequested) / (1024.0 * 1024.0),
+            static_cast<double>(heap->usedSize()) / (1024.0 * 1024.0),
+            static_cast<double>(heap->committedSize()) / (1024.0 * 1024.0),
+            static_cast<unsigned>(failedCount));
+
+    for (size_t i = 0; i < LiveCount; ++i) {
+        if (blocks[i])
+            heap->free(blocks[i]);
+    }
+}
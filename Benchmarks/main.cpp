@@ -0,0 +1,58 @@
+#include "SDL.h" // To substitute main with SDL_main
+
+#include <cstring>
+
+#include "Benchmark.hpp"
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/SmallObjectPool.hpp"
+
+static const size_t HeapReserveSize = sizeof(void*) >= 8
+    ? static_cast<size_t>(4) * 1024 * 1024 * 1024
+    : 256 * 1024 * 1024;
+
+std::atomic<uint64_t> benchmark::sink {0};
+
+struct Suite {
+    const char* name;
+    void (*run)(LinearAllocator& alloc);
+};
+
+static const Suite suites[] = {
+    {"Allocation", &benchmarkAllocation},
+    {"Churn", &benchmarkChurn},
+    {"Job", &benchmarkJob},
+    {"JobQueue", &benchmarkJobQueue},
+    {"ParallelFor", &benchmarkParallelFor},
+    {"Profiler", &benchmarkProfiler},
+    {"Registry", &benchmarkRegistry},
+    {"SlotMap", &benchmarkSlotMap},
+    {"Tlsf", &benchmarkTlsf}
+};
+
+// Runs every suite or only the ones named on the command line
+int main(int argc, char** argv) {
+    LinearAllocator heap(HeapReserveSize, VirtualMemory::NormalPages, "Benchmark heap");
+    SmallObjectPool::DefaultInstance smallObjectPool(heap);
+
+#if !defined(NDEBUG) && !defined(_NDEBUG)
+    SDL_Log("Debug build, numbers include assertions and debug fills");
+#endif
+
+    for (const Suite& suite : suites) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            selected |= strcmp(argv[i], suite.name) == 0;
+
+        if (!selected)
+            continue;
+
+        SDL_Log("%s", suite.name);
+
+        const LinearAllocator::RewindMarker marker = heap.rewindMarker();
+        suite.run(heap);
+        heap.rewind(marker);
+    }
+
+    SmallObjectPool::releaseThreadCache();
+    return 0;
+}
@@ -8,16 +8,24 @@
 #include "Core/Concurrency/Job.hpp"
 #include "Core/Concurrency/JobQueue.hpp"
 #include "Core/FontRegistry.hpp"
+#include "Core/HashNames.hpp"
+#include "Core/Name.hpp"
+#include "Core/Profiler.hpp"
 #include "Core/SpriteRegistry.hpp"
 #include "Core/TextureRegistry.hpp"
 #include "GFX/Animation/AnimationSystem.hpp"
 #include "GFX/Render.hpp"
+#include "GFX/UploadQueue.hpp"
 #include "GFX/Window.hpp"
 #include "Input/Input.hpp"
+#include "Memory/AllocationTracker.hpp"
 #include "Memory/DoubleEndedLinearAllocator.hpp"
-#include "Memory/LinearAllocator.hpp"
+#include "Memory/FrameAllocator.hpp"
+#include "Memory/MemoryTelemetry.hpp"
+#include "Memory/ScratchAllocator.hpp"
 #include "Memory/ScopeStack.hpp"
 #include "Memory/SmallObjectPool.hpp"
+#include "Memory/TlsfAllocator.hpp"
 #include "String.hpp"
 #include "Util/Registry.hpp"
 
@@ -28,9 +36,23 @@ static const int64_t MaxTimeDiff = Second / 4;
 
 static const size_t MaxUpdateCount = 5;
 
-static const size_t AppHeapSize = 64 * 1024 * 1024;
+static const size_t MaxUploadCountPerFrame = 4;
+static const size_t MaxUploadBytesPerFrame = 4 * 1024 * 1024;
+
+// Only address space is reserved up front, memory is committed as the heap grows
+static const size_t AppHeapReserveSize = sizeof(void*) >= 8
+    ? static_cast<size_t>(4) * 1024 * 1024 * 1024
+    : 256 * 1024 * 1024;
 static const size_t ScratchBufferSize = 1024;
 
+#ifdef ENABLE_PROFILER
+static const char ProfilerTraceFileName[] = "trace.json";
+#endif // ENABLE_PROFILER
+
+#ifdef ENABLE_MEMORY_TELEMETRY
+static const char MemoryTimelineFileName[] = "memory.csv";
+#endif // ENABLE_MEMORY_TELEMETRY
+
 int64_t getSystemTicks() {
     return SDL_GetPerformanceCounter();
 }
@@ -56,13 +78,23 @@ Application::~Application() {
     SDL_Quit();
 }
 
-static uint8_t appHeap[AppHeapSize];
-
 void Application::run() {
-    AppAlloc appAlloc(std::begin(appHeap), std::end(appHeap));
+    AppAlloc appAlloc(AppHeapReserveSize, VirtualMemory::NormalPages, "App heap");
 
     SmallObjectPool::DefaultInstance smallObjectPool(appAlloc);
-
+    ScratchBlockPool::DefaultInstance scratchBlockPool(appAlloc);
+    HashNames::DefaultInstance hashNames(appAlloc);
+    NameTable::DefaultInstance nameTable(appAlloc);
+
+#ifdef ENABLE_PROFILER
+    // workers record events until the job queue is destroyed
+    Profiler::DefaultInstance profiler(appAlloc);
+#endif // ENABLE_PROFILER
+
+    // jobs may post uploads and hand frame data over until the job queue is destroyed
+    FrameAllocator::DefaultInstance frameAllocator(appAlloc);
+    TlsfAllocator::DefaultInstance tlsfHeap(appAlloc);
+    UploadQueue::DefaultInstance uploadQueue(appAlloc);
     JobQueue::DefaultInstance jobQueue(appAlloc);
 
     TextureRegistry::DefaultInstance textureRegistry(appAlloc);
@@ -77,14 +109,26 @@ void Application::run() {
     SDL_DisplayMode mode;
     SDL_GetDesktopDisplayMode(0, &mode);
 
-    ScopeStack<AppAlloc> appScope(appAlloc);
+    ScopeStack<AppAlloc> appScope(appAlloc, "App scope");
 
     Window* window = appScope.create<Window>(mode.w, mode.h);
     mainLoop(window, appAlloc);
+
+#ifdef ENABLE_PROFILER
+    if (!Profiler::getDefault().dump(ProfilerTraceFileName))
+        SDL_Log("Could not write profiler trace");
+#endif // ENABLE_PROFILER
+
+#ifdef ENABLE_MEMORY_TELEMETRY
+    if (!MemoryTelemetry::dumpTimeline(MemoryTimelineFileName))
+        SDL_Log("Could not write memory timeline");
+#endif // ENABLE_MEMORY_TELEMETRY
 }
 
 void Application::mainLoop(Window* window, AppAlloc& alloc) {
-    ScopeStack<AppAlloc> mainScope(alloc);
+    PROFILE_THREAD("Main");
+
+    ScopeStack<AppAlloc> mainScope(alloc, "Main scope");
 
     Input input(mainScope);
     input.applicationExitRequested.subscribe(make_delegate([this]() {
@@ -94,13 +138,22 @@ void Application::mainLoop(Window* window, AppAlloc& alloc) {
     Render render(mainScope);
 
     uint8_t scratchBuffer[ScratchBufferSize];
-    LinearAllocator scratch(std::begin(scratchBuffer), std::end(scratchBuffer));
+    ScratchAllocator scratch(std::begin(scratchBuffer), std::end(scratchBuffer),
+                             ScratchBlockPool::getDefault(), "Frame scratch");
 
     int64_t accumulatedTime = 0;
     while (!_done) {
-        ScopeStack<LinearAllocator> frameScope(scratch);
+        PROFILE_FRAME("Frame");
+        MemoryTelemetry::markFrame();
+        AllocationTracker::markFrame();
+        FrameAllocator::getDefault().nextFrame();
+
+        ScopeStack<ScratchAllocator> frameScope(scratch, "Frame scope");
 
-        input.processEvents(window);
+        {
+            PROFILE_ZONE("Input");
+            input.processEvents(window);
+        }
 
         _lastTime = _newTime;
         _newTime = getSystemTicks();
@@ -116,6 +169,7 @@ void Application::mainLoop(Window* window, AppAlloc& alloc) {
         accumulatedTime += diff;
         size_t updateCount = 0;
         while (accumulatedTime >= UpdateInterval && updateCount < MaxUpdateCount) {
+            PROFILE_ZONE("Update");
             accumulatedTime -= UpdateInterval;
 
             //TODO: update game and interpolate state
@@ -124,9 +178,17 @@ void Application::mainLoop(Window* window, AppAlloc& alloc) {
             ++updateCount;
         }
 
-        render.render(frameScope, window);
+        UploadQueue::getDefault().process(MaxUploadBytesPerFrame, MaxUploadCountPerFrame);
 
-        window->swapBuffers();
+        {
+            PROFILE_ZONE("Render");
+            render.render(frameScope, window);
+        }
+
+        {
+            PROFILE_ZONE("Swap");
+            window->swapBuffers();
+        }
 
         ++_renderFps;
     }
@@ -2,19 +2,46 @@
 
 #include <cassert>
 
+#include "JobCounter.hpp"
+
 Job::Job() :
-    function {nullptr},
-    payload {nullptr}
+    invoker {nullptr},
+    deleter {nullptr},
+    payload(),
+    counter {nullptr},
+    submitTicks {0}
 {
 }
 
 Job::Job(ConstJobFunction function, void* const payload /*= nullptr*/) :
-    function {function},
-    payload {payload}
+    invoker {&invokeFunction},
+    deleter {nullptr},
+    payload(),
+    counter {nullptr},
+    submitTicks {0}
 {
+    static_assert(sizeof(FunctionPayload) <= PayloadSize, "Job payload can't hold a function and its argument");
+
+    const FunctionPayload stored = {function, payload};
+    new (&this->payload) FunctionPayload(stored);
+}
+
+void Job::invokeFunction(void* payload) {
+    const auto stored = static_cast<FunctionPayload*>(payload);
+    stored->function(stored->payload);
 }
 
 void Job::run() {
-    assert(("Trying to execute empty job", function));
-    function(payload);
+    assert(("Trying to execute empty job", invoker));
+    invoker(&payload);
+
+    if (deleter)
+        deleter(&payload);
+
+    if (counter)
+        counter->decrement();
+}
+
+bool Job::empty() const {
+    return invoker == nullptr;
 }
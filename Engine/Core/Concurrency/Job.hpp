@@ -1,19 +1,74 @@
 #ifndef Job_h__
 #define Job_h__
 
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+class JobCounter;
+
+// Job stores its payload inline, so submitting small closures doesn't allocate.
+//
+// Jobs are copied around the queues bitwise and the payload is destroyed
+// right after the job runs, so a stored functor must not depend on its own address
 struct Job {
     typedef void (* const ConstJobFunction)(void*);
 
+    static const size_t PayloadSize = 4 * sizeof(void*);
+
     Job();
     Job(ConstJobFunction function, void* const payload = nullptr);
 
+    template <class Functor>
+    static Job create(Functor&& functor) {
+        typedef typename std::decay<Functor>::type Type;
+        static_assert(sizeof(Type) <= PayloadSize, "Functor is too big to be stored inside a job");
+        static_assert(PayloadAlignment % std::alignment_of<Type>::value == 0, "Unsupported functor alignment");
+
+        Job job;
+        new (&job.payload) Type(std::forward<Functor>(functor));
+        job.invoker = &invokeFunctor<Type>;
+        job.deleter = std::is_trivially_destructible<Type>::value ? nullptr : &destroyFunctor<Type>;
+        return job;
+    }
+
     void run();
 
+    bool empty() const;
+
 private:
+    friend class JobQueue;
+
     typedef void (* JobFunction)(void*);
+    typedef void (* Invoker)(void*);
+    typedef void (* Deleter)(void*);
+
+    static const size_t PayloadAlignment = std::alignment_of<uint64_t>::value;
+    typedef std::aligned_storage<PayloadSize, PayloadAlignment>::type Payload;
+
+    struct FunctionPayload {
+        JobFunction function;
+        void* payload;
+    };
+
+    template <class Functor>
+    static void invokeFunctor(void* payload) {
+        (*static_cast<Functor*>(payload))();
+    }
+
+    template <class Functor>
+    static void destroyFunctor(void* payload) {
+        static_cast<Functor*>(payload)->~Functor();
+    }
+
+    static void invokeFunction(void* payload);
 
-    JobFunction function;
-    void* payload;
+    Invoker invoker;
+    Deleter deleter;
+    Payload payload;
+    JobCounter* counter;
+    uint64_t submitTicks;
 };
 
 #endif // Job_h__
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef JobCounter_h__
+#define JobCounter_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+// Counts jobs that are not finished yet
+//
+// JobQueue increments the counter when a job is added and the job decrements it
+// once it has run, so everything written by the jobs is visible after done returns true
+class JobCounter : public util::Noncopyable {
+    std::atomic<size_t> _pending;
+
+public:
+    JobCounter() NOEXCEPT :
+        _pending {0}
+    {}
+
+    ~JobCounter() {
+        assert(("Destroying counter of unfinished jobs", done()));
+    }
+
+    void increment(const size_t count = 1) NOEXCEPT {
+        _pending.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void decrement() NOEXCEPT {
+        const size_t pending = _pending.fetch_sub(1, std::memory_order_release);
+        assert(("Counter underflow", pending > 0));
+    }
+
+    bool done() const NOEXCEPT {
+        return _pending.load(std::memory_order_acquire) == 0;
+    }
+};
+
+#endif // JobCounter_h__
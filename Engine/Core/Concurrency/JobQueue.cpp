@@ -1,48 +1,336 @@
 #include "JobQueue.hpp"
 
 #include <algorithm>
+#include <thread>
 
+#include "SDL_cpuinfo.h"
+#include "SDL_mutex.h"
 #include "SDL_thread.h"
+#include "SDL_timer.h"
+
+#include "Core/Memory/SmallObjectPool.hpp"
+#include "Core/Profiler.hpp"
+
+// std::min takes it by reference
+const size_t JobQueue::MaxWorkerCount;
+
+// queue and deque index owned by the current worker thread
+static thread_local const JobQueue* currentQueue = nullptr;
+static thread_local size_t currentDeque = 0;
+
+static inline void cpuRelax() {
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
 
 int JobQueue::Worker::threadRun(void* data) {
-    static_cast<JobQueue::Worker*>(data)->run();
+    auto worker = static_cast<JobQueue::Worker*>(data);
+
+    currentQueue = &worker->queue;
+    currentDeque = worker->index;
+
+    PROFILE_THREAD("JobQueue::Worker");
+
+    worker->run();
+
+    SmallObjectPool::releaseThreadCache();
     return 0;
 }
 
-JobQueue::Worker::Worker(State& state) :
-    state(state), //XXX: gcc bug prevents from using brace initialization syntax
+JobQueue::Worker::Worker(JobQueue& queue, const size_t index) :
+    queue(queue), //XXX: gcc bug prevents from using brace initialization syntax
+    index {index},
     done {false},
-    thread {SDL_CreateThread(&threadRun, "JobQueue::Worker", this)}
+    thread {nullptr},
+    frameStreak {0},
+    wakeups {0},
+    spinTicks {0},
+    parkTicks {0}
 {
 }
 
+void JobQueue::Worker::start() {
+    thread = SDL_CreateThread(&threadRun, "JobQueue::Worker", this);
+}
+
 void JobQueue::Worker::run() {
     Job job;
+    Priority lane;
 
-    while (!done) {
-        if (state.begin >= state.end)
+    size_t idleCount = 0;
+    uint64_t idleStart = 0;
+
+    while (!done.load(std::memory_order_acquire)) {
+        if (queue.fetchJob(index, Background, job, lane)) {
+            if (idleCount) {
+                spinTicks.fetch_add(currentTicks() - idleStart, std::memory_order_relaxed);
+                idleCount = 0;
+            }
+
+            queue.runJob(job, lane);
             continue;
+        }
+
+        if (!idleCount)
+            idleStart = currentTicks();
 
-        // fetch new job
-        job = state.queue[state.begin & (MaxJobCount - 1)];
+        ++idleCount;
+        if (idleCount < IdleSpinCount) {
+            cpuRelax();
+        } else if (idleCount < IdleSpinCount + IdleYieldCount) {
+            std::this_thread::yield();
+        } else {
+            const uint64_t parkStart = currentTicks();
+            spinTicks.fetch_add(parkStart - idleStart, std::memory_order_relaxed);
 
-        ++state.begin;
+            const bool found = park(job, lane);
 
-        job.run();
+            const uint64_t parkEnd = currentTicks();
+            parkTicks.fetch_add(parkEnd - parkStart, std::memory_order_relaxed);
+            idleStart = parkEnd;
+
+            if (found) {
+                idleCount = 0;
+                queue.runJob(job, lane);
+            } else {
+                idleCount = 1;
+            }
+        }
     }
 }
 
+// Sleeps until a job is added. Returns true if a job was fetched while going to sleep
+//
+// Registering as sleeping and checking for jobs pairs with adding a job and checking
+// for sleepers in add, so either the worker sees the job or the producer sees the sleeper
+bool JobQueue::Worker::park(Job& job, Priority& lane) {
+    queue._sleepingCount.fetch_add(1, std::memory_order_seq_cst);
+
+    if (queue.fetchJob(index, Background, job, lane)) {
+        // try to take our registration back
+        size_t sleeping = queue._sleepingCount.load(std::memory_order_relaxed);
+        while (sleeping) {
+            if (queue._sleepingCount.compare_exchange_weak(sleeping, sleeping - 1, std::memory_order_acq_rel))
+                return true;
+        }
+
+        // somebody already decided to wake us up, consume the signal
+        SDL_SemWait(queue._wakeup);
+        return true;
+    }
+
+    SDL_SemWait(queue._wakeup);
+    wakeups.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+size_t JobQueue::defaultWorkerCount() {
+    const int cpuCount = SDL_GetCPUCount();
+    return std::min(static_cast<size_t>(std::max(cpuCount - 1, 1)), MaxWorkerCount);
+}
+
+uint64_t JobQueue::currentTicks() {
+    return SDL_GetPerformanceCounter();
+}
+
+void JobQueue::start() {
+    _wakeup = SDL_CreateSemaphore(0);
+    assert(_wakeup);
+
+    for (size_t i = 0; i < _workerCount; ++i)
+        _workers[i].start();
+}
+
 JobQueue::~JobQueue() {
-    _worker.done = true;
+    for (size_t i = 0; i < _workerCount; ++i)
+        _workers[i].done.store(true, std::memory_order_release);
+
+    // wake up everyone, parked or not
+    for (size_t i = 0; i < _workerCount; ++i)
+        SDL_SemPost(_wakeup);
+
+    for (size_t i = 0; i < _workerCount; ++i)
+        SDL_WaitThread(_workers[i].thread, nullptr);
+
+    for (size_t i = 0; i < _workerCount; ++i)
+        _workers[i].~Worker();
+
+    for (size_t i = 0; i < _workerCount; ++i)
+        _deques[i].~WorkStealingDeque();
+
+    SDL_DestroySemaphore(_wakeup);
+}
+
+template <typename T>
+static void updateMax(std::atomic<T>& maximum, const T value) {
+    T current = maximum.load(std::memory_order_relaxed);
+    while (current < value && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+// Pass worker index to pop from its deque first or
+// _workerCount when called from any other thread
+bool JobQueue::fetchFrameJob(const size_t index, Job& job) {
+    if (index < _workerCount && _deques[index].pop(job))
+        return true;
+
+    if (_lanes[FrameCritical].jobs.tryPop(job))
+        return true;
+
+    // walk over other deques starting with the next one
+    // so that thieves do not gang up on the same victim
+    for (size_t i = 1; i <= _workerCount; ++i) {
+        const size_t victim = (index + i) % _workerCount;
+        if (victim != index && _deques[victim].steal(job))
+            return true;
+    }
+
+    return false;
+}
 
-    SDL_WaitThread(_worker.thread, nullptr);
+bool JobQueue::fetchJob(const size_t index, const Priority lowest, Job& job, Priority& lane) {
+    const bool isWorker = index < _workerCount;
+    const bool canRunBackground = lowest == Background;
+
+    // starvation guard, background jobs get a chance even when frame jobs keep coming
+    if (isWorker && canRunBackground && _workers[index].frameStreak >= BackgroundGuardInterval) {
+        _workers[index].frameStreak = 0;
+
+        if (_lanes[Background].jobs.tryPop(job)) {
+            lane = Background;
+            return true;
+        }
+    }
+
+    if (fetchFrameJob(index, job)) {
+        lane = FrameCritical;
+        if (isWorker)
+            ++_workers[index].frameStreak;
+        return true;
+    }
+
+    if (canRunBackground && _lanes[Background].jobs.tryPop(job)) {
+        lane = Background;
+        if (isWorker)
+            _workers[index].frameStreak = 0;
+        return true;
+    }
+
+    return false;
+}
+
+void JobQueue::runJob(Job& job, const Priority lane) {
+    const uint64_t latency = currentTicks() - job.submitTicks;
+
+    Lane& stats = _lanes[lane];
+    stats.jobCount.fetch_add(1, std::memory_order_relaxed);
+    stats.totalLatencyTicks.fetch_add(latency, std::memory_order_relaxed);
+    updateMax(stats.maxLatencyTicks, latency);
+
+    PROFILE_ZONE(lane == FrameCritical ? "Job" : "Background job");
+    job.run();
+}
+
+void JobQueue::wakeWorker() {
+    // pairs with registering as sleeping in Worker::park
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    size_t sleeping = _sleepingCount.load(std::memory_order_relaxed);
+    while (sleeping) {
+        if (_sleepingCount.compare_exchange_weak(sleeping, sleeping - 1, std::memory_order_acq_rel)) {
+            SDL_SemPost(_wakeup);
+            return;
+        }
+    }
 }
 
-void JobQueue::add(const Job& job) {
-    assert(("Job queue is too busy", _state.end - _state.begin < MaxJobCount));
+void JobQueue::pushToLane(const Job& job, const Priority lane) {
+    MPMCQueue<Job>& jobs = _lanes[lane].jobs;
+
+    // help draining the queue instead of failing when it is full
+    while (!jobs.tryPush(job)) {
+        runPendingJob(lane);
+    }
+
+    updateMax(_lanes[lane].peakDepth, jobs.size());
+}
+
+void JobQueue::add(const Job& job, const Priority priority /*= FrameCritical*/) {
+    assert(("Invalid priority", priority < PriorityCount));
+
+    Job submitted = job;
+    submitted.submitTicks = currentTicks();
+
+    // workers keep their frame jobs local unless their deque overflows
+    const bool addedLocally =
+        priority == FrameCritical && currentQueue == this && _deques[currentDeque].push(submitted);
+
+    if (!addedLocally)
+        pushToLane(submitted, priority);
+
+    wakeWorker();
+}
+
+void JobQueue::add(const Job& job, JobCounter& counter, const Priority priority /*= FrameCritical*/) {
+    assert(("Job is already tracked by a counter", !job.counter));
+    counter.increment();
+
+    Job tracked = job;
+    tracked.counter = &counter;
+    add(tracked, priority);
+}
+
+void JobQueue::wait(const JobCounter& counter, const Priority lowest /*= FrameCritical*/) {
+    while (!counter.done()) {
+        // the job we are waiting for may be running on another thread
+        if (!runPendingJob(lowest))
+            cpuRelax();
+    }
+}
+
+bool JobQueue::runPendingJob(const Priority lowest /*= Background*/) {
+    Job job;
+    Priority lane;
+
+    const size_t index = currentQueue == this ? currentDeque : _workerCount;
+    if (!fetchJob(index, lowest, job, lane))
+        return false;
+
+    runJob(job, lane);
+    return true;
+}
+
+JobQueue::Stats JobQueue::stats() const {
+    Stats stats = {0, 0, 0};
+    for (size_t i = 0; i < _workerCount; ++i) {
+        stats.wakeups += _workers[i].wakeups.load(std::memory_order_relaxed);
+        stats.spinTicks += _workers[i].spinTicks.load(std::memory_order_relaxed);
+        stats.parkTicks += _workers[i].parkTicks.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+JobQueue::LaneStats JobQueue::laneStats(const Priority priority) const {
+    assert(("Invalid priority", priority < PriorityCount));
+    const Lane& lane = _lanes[priority];
+
+    size_t depth = lane.jobs.size();
+    if (priority == FrameCritical) {
+        for (size_t i = 0; i < _workerCount; ++i)
+            depth += _deques[i].size();
+    }
 
-    _state.queue[_state.end & (MaxJobCount - 1)] = job;
-    ++_state.end;
+    const LaneStats stats = {
+        lane.jobCount.load(std::memory_order_relaxed),
+        lane.totalLatencyTicks.load(std::memory_order_relaxed),
+        lane.maxLatencyTicks.load(std::memory_order_relaxed),
+        depth,
+        lane.peakDepth.load(std::memory_order_relaxed)
+    };
+    return stats;
 }
 
 JobQueue* JobQueue::DefaultInstance::defaultInstance;
@@ -1,77 +1,190 @@
 #ifndef JobQueue_h__
 #define JobQueue_h__
 
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <new>
 #include <type_traits>
 
 #include "Job.hpp"
+#include "JobCounter.hpp"
+#include "MPMCQueue.hpp"
+#include "WorkStealingDeque.hpp"
 #include "Util/noncopyable.hpp"
 
+struct SDL_semaphore;
 struct SDL_Thread;
 
 class JobQueue : public util::Noncopyable {
-    static const size_t MaxJobCount = 32;
+public:
+    // Workers always drain frame critical jobs first, background jobs only run
+    // when there is nothing else to do or when the starvation guard kicks in
+    enum Priority {
+        FrameCritical,
+        Background,
+        PriorityCount
+    };
+
+    // Times are in performance counter ticks
+    struct Stats {
+        uint64_t wakeups;
+        uint64_t spinTicks;
+        uint64_t parkTicks;
+    };
+
+    // Latency is measured from adding a job to starting it
+    struct LaneStats {
+        uint64_t jobCount;
+        uint64_t totalLatencyTicks;
+        uint64_t maxLatencyTicks;
+        size_t depth;
+        size_t peakDepth;
+    };
+
+private:
+    static const size_t MaxJobCount = 256;
     static_assert((MaxJobCount & (MaxJobCount - 1)) == 0, "MaxJobCount must be power of two");
 
-    static const size_t JobStorageSize = MaxJobCount * sizeof(Job);
-    static const size_t JobAlignment = std::alignment_of<Job>::value;
+    static const size_t MaxWorkerCount = 32;
 
-    struct State {
-        Job* queue;
-        size_t begin;
-        size_t end;
+    // Idle workers spin for a while, then yield their time slice
+    // and finally park until a new job is added
+    static const size_t IdleSpinCount = 256;
+    static const size_t IdleYieldCount = 16;
 
-        template <typename Allocator>
-        State(Allocator& alloc) :
-            queue {static_cast<Job*>(alloc.allocate(JobStorageSize, JobAlignment, 0))},
-            begin {0},
-            end {0}
-        {}
-    };
+    // Workers look at the background lane first after running that many frame jobs in a row
+    static const size_t BackgroundGuardInterval = 32;
 
-    // make worker an object to enable multiple workers, if needed
+    static const size_t DequeAlignment = std::alignment_of<WorkStealingDeque>::value;
+
+    // Frame critical jobs added by the workers go to their own deques, jobs added by any other
+    // thread go to the lane of their priority. Workers drain their own deque first,
+    // then the frame critical lane, then try to steal from each other and only then
+    // look at the background lane
     struct Worker {
-        State& state;
-        bool done;
+        JobQueue& queue;
+        const size_t index;
+        std::atomic<bool> done;
         SDL_Thread* thread;
 
+        // touched only by the worker thread
+        size_t frameStreak;
+
+        std::atomic<uint64_t> wakeups;
+        std::atomic<uint64_t> spinTicks;
+        std::atomic<uint64_t> parkTicks;
+
         static int threadRun(void* data);
 
-        Worker(State& state);
+        Worker(JobQueue& queue, const size_t index);
 
+        void start();
         void run();
+        bool park(Job& job, Priority& lane);
+    };
+
+    static const size_t WorkerAlignment = std::alignment_of<Worker>::value;
+
+    struct Lane {
+        MPMCQueue<Job> jobs;
+
+        std::atomic<uint64_t> jobCount;
+        std::atomic<uint64_t> totalLatencyTicks;
+        std::atomic<uint64_t> maxLatencyTicks;
+        std::atomic<size_t> peakDepth;
+
+        template <typename Allocator>
+        Lane(Allocator& alloc) :
+            jobs {alloc, MaxJobCount},
+            jobCount {0},
+            totalLatencyTicks {0},
+            maxLatencyTicks {0},
+            peakDepth {0}
+        {}
     };
 
-    State _state;
-    Worker _worker;
+    static size_t defaultWorkerCount();
+    static uint64_t currentTicks();
+
+    const size_t _workerCount;
+    Lane _lanes[PriorityCount];
+    WorkStealingDeque* const _deques;
+    Worker* const _workers;
+
+    // Number of parked workers nobody has woken up yet
+    std::atomic<size_t> _sleepingCount;
+    SDL_semaphore* _wakeup;
+
+    bool fetchFrameJob(const size_t index, Job& job);
+    bool fetchJob(const size_t index, const Priority lowest, Job& job, Priority& lane);
+    void runJob(Job& job, const Priority lane);
+    void pushToLane(const Job& job, const Priority lane);
+    void wakeWorker();
+
+    void start();
 
 public:
     struct DefaultInstance {
         static JobQueue* defaultInstance;
 
         template <typename Allocator>
-        DefaultInstance(Allocator& alloc) {
+        DefaultInstance(Allocator& alloc, const size_t workerCount = 0) {
             assert(("Trying to initialize default instance twice", !defaultInstance));
             void* const memory =
                 alloc.allocate(sizeof(JobQueue), std::alignment_of<JobQueue>::value, 0);
-            defaultInstance = new (memory) JobQueue(alloc);
+            defaultInstance = new (memory) JobQueue(alloc, workerCount);
         }
         ~DefaultInstance();
     };
 
     static JobQueue& getDefault();
 
+    // Passing zero worker count spawns a worker per hardware thread,
+    // leaving one for the main thread
     template <typename Allocator>
-    JobQueue(Allocator& alloc) :
-        _state {alloc},
-        _worker {_state}
-    {}
+    JobQueue(Allocator& alloc, const size_t workerCount = 0) :
+        _workerCount {workerCount ? workerCount : defaultWorkerCount()},
+        _lanes {{alloc}, {alloc}},
+        _deques {static_cast<WorkStealingDeque*>(alloc.allocate(_workerCount * sizeof(WorkStealingDeque), DequeAlignment, 0))},
+        _workers {static_cast<Worker*>(alloc.allocate(_workerCount * sizeof(Worker), WorkerAlignment, 0))},
+        _sleepingCount {0},
+        _wakeup {nullptr}
+    {
+        assert(("Too many workers", _workerCount <= MaxWorkerCount));
+
+        for (size_t i = 0; i < _workerCount; ++i)
+            new (&_deques[i]) WorkStealingDeque(alloc, MaxJobCount);
+
+        for (size_t i = 0; i < _workerCount; ++i)
+            new (&_workers[i]) Worker(*this, i);
+
+        // threads are started only after all deques are ready to be stolen from
+        start();
+    }
 
     ~JobQueue();
 
-    void add(const Job& job);
+    size_t workerCount() const NOEXCEPT {
+        return _workerCount;
+    }
+
+    // Safe to call from any thread, including workers
+    void add(const Job& job, const Priority priority = FrameCritical);
+
+    // Adds a job that decrements the counter once it has run
+    void add(const Job& job, JobCounter& counter, const Priority priority = FrameCritical);
+
+    // Runs pending jobs down to the given priority until all jobs tracked by the counter are finished
+    void wait(const JobCounter& counter, const Priority lowest = FrameCritical);
+
+    // Lets the calling thread help to drain the queue. Returns false if no job was found
+    bool runPendingJob(const Priority lowest = Background);
+
+    // Accumulated idle statistics of all workers
+    Stats stats() const;
+
+    LaneStats laneStats(const Priority priority) const;
 };
 
 #endif // JobQueue_h__
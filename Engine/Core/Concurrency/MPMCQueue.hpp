@@ -0,0 +1,118 @@
+#ifndef MPMCQueue_h__
+#define MPMCQueue_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+// Bounded lock-free multi-producer multi-consumer queue
+//
+// Every cell carries a sequence number telling whose turn it is to use the cell:
+// sequence == position      - cell is free and can be written by the producer at position
+// sequence == position + 1  - cell is filled and can be read by the consumer at position
+//
+// Producer publishes the value by storing the sequence with release semantics,
+// consumer hands the cell back to producers of the next lap the same way
+template <typename T>
+class MPMCQueue : public util::Noncopyable {
+    static const size_t CacheLineSize = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static const size_t CellAlignment = std::alignment_of<Cell>::value;
+
+    Cell* const _cells;
+    const size_t _mask;
+    uint8_t _pad0[CacheLineSize - sizeof(Cell*) - sizeof(size_t)];
+
+    // producers and consumers live on separate cache lines
+    std::atomic<size_t> _enqueuePosition;
+    uint8_t _pad1[CacheLineSize - sizeof(std::atomic<size_t>)];
+
+    std::atomic<size_t> _dequeuePosition;
+    uint8_t _pad2[CacheLineSize - sizeof(std::atomic<size_t>)];
+
+public:
+    template <typename Allocator>
+    MPMCQueue(Allocator& alloc, const size_t capacity) NOEXCEPT :
+        _cells {static_cast<Cell*>(alloc.allocate(capacity * sizeof(Cell), CellAlignment, 0))},
+        _mask {capacity - 1},
+        _enqueuePosition {0},
+        _dequeuePosition {0}
+    {
+        assert(("Capacity must be power of two", capacity >= 2 && (capacity & (capacity - 1)) == 0));
+
+        for (size_t i = 0; i < capacity; ++i) {
+            new (&_cells[i].sequence) std::atomic<size_t>(i);
+            new (&_cells[i].value) T();
+        }
+    }
+
+    ~MPMCQueue() {
+        for (size_t i = 0; i <= _mask; ++i)
+            _cells[i].value.~T();
+    }
+
+    bool tryPush(const T& value) NOEXCEPT {
+        size_t position = _enqueuePosition.load(std::memory_order_relaxed);
+
+        for (;;) {
+            Cell& cell = _cells[position & _mask];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (difference == 0) {
+                if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // queue is full or the consumer of the previous lap has not finished reading yet
+                return false;
+            } else {
+                position = _enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& value) NOEXCEPT {
+        size_t position = _dequeuePosition.load(std::memory_order_relaxed);
+
+        for (;;) {
+            Cell& cell = _cells[position & _mask];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+            if (difference == 0) {
+                if (_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = cell.value;
+                    cell.sequence.store(position + _mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // queue is empty
+                return false;
+            } else {
+                position = _dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate, other threads may change it right away
+    size_t size() const NOEXCEPT {
+        const size_t enqueued = _enqueuePosition.load(std::memory_order_relaxed);
+        const size_t dequeued = _dequeuePosition.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+};
+
+#endif // MPMCQueue_h__
@@ -0,0 +1,91 @@
+#ifndef ParallelFor_h__
+#define ParallelFor_h__
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+#include "Job.hpp"
+#include "JobCounter.hpp"
+#include "JobQueue.hpp"
+#include "Util/noncopyable.hpp"
+
+namespace detail {
+
+// Shared by all jobs of one parallel_for call, lives on the caller's stack.
+// Jobs grab chunks dynamically so that a slow chunk doesn't stall the others
+template <typename Function>
+struct ParallelForContext : public util::Noncopyable {
+    Function& function;
+    std::atomic<size_t> next;
+    const size_t end;
+    const size_t grain;
+
+    ParallelForContext(Function& function, const size_t begin, const size_t end, const size_t grain) :
+        function(function), //XXX: gcc bug prevents from using brace initialization syntax
+        next {begin},
+        end {end},
+        grain {grain}
+    {}
+
+    static void run(void* payload) {
+        auto context = static_cast<ParallelForContext*>(payload);
+
+        for (;;) {
+            const size_t from = context->next.fetch_add(context->grain, std::memory_order_relaxed);
+            if (from >= context->end)
+                return;
+
+            context->function(from, std::min(from + context->grain, context->end));
+        }
+    }
+};
+
+}
+
+// Chunks per thread used to pick the grain size, more chunks balance better
+// but cost more scheduling
+static const size_t ParallelForChunksPerThread = 4;
+
+// Ranges smaller than this are not worth splitting
+static const size_t ParallelForMinGrain = 64;
+
+// Calls function(from, to) for consecutive sub-ranges of [begin, end) on JobQueue workers
+// and returns when all of them are done. The calling thread processes chunks too.
+//
+// Passing zero grain picks it from range size and worker count.
+// Ranges that fit into a single chunk run inline
+template <typename Function>
+void parallel_for(const size_t begin, const size_t end, const size_t grain, Function&& function) {
+    if (begin >= end)
+        return;
+
+    JobQueue& queue = JobQueue::getDefault();
+    const size_t threadCount = queue.workerCount() + 1;
+    const size_t count = end - begin;
+
+    const size_t chunkSize = grain
+        ? grain
+        : std::max(ParallelForMinGrain, count / (threadCount * ParallelForChunksPerThread));
+
+    if (count <= chunkSize) {
+        function(begin, end);
+        return;
+    }
+
+    detail::ParallelForContext<Function> context(function, begin, end, chunkSize);
+
+    // caller takes one share of the work itself
+    const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    const size_t jobCount = std::min(chunkCount, threadCount) - 1;
+
+    JobCounter counter;
+    for (size_t i = 0; i < jobCount; ++i)
+        queue.add(Job(&detail::ParallelForContext<Function>::run, &context), counter);
+
+    detail::ParallelForContext<Function>::run(&context);
+
+    queue.wait(counter);
+}
+
+#endif // ParallelFor_h__
@@ -0,0 +1,61 @@
+#include "WorkStealingDeque.hpp"
+
+bool WorkStealingDeque::push(const Job& job) NOEXCEPT {
+    const int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    const int64_t top = _top.load(std::memory_order_acquire);
+    if (bottom - top > _mask)
+        return false;
+
+    _jobs[bottom & _mask] = job;
+
+    // publish the job before thieves can see the new bottom
+    std::atomic_thread_fence(std::memory_order_release);
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WorkStealingDeque::pop(Job& job) NOEXCEPT {
+    const int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    _bottom.store(bottom, std::memory_order_relaxed);
+
+    // reserving the bottom job must be ordered before reading top
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = _top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        // deque was empty
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    job = _jobs[bottom & _mask];
+    if (top != bottom)
+        return true;
+
+    // last job left, race against thieves for it
+    const bool won =
+        _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+    return won;
+}
+
+bool WorkStealingDeque::steal(Job& job) NOEXCEPT {
+    int64_t top = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = _bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom)
+        return false;
+
+    // The slot may be overwritten by the owner once another thief takes it,
+    // in that case CAS below fails and the copy is discarded
+    job = _jobs[top & _mask];
+
+    return _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+size_t WorkStealingDeque::size() const NOEXCEPT {
+    const int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    const int64_t top = _top.load(std::memory_order_relaxed);
+    return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+}
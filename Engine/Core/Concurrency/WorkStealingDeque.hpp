@@ -0,0 +1,53 @@
+#ifndef WorkStealingDeque_h__
+#define WorkStealingDeque_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+#include "Job.hpp"
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+// Bounded Chase-Lev deque
+//
+// Only the owning thread may push and pop jobs, they are taken from the bottom
+// of the deque in LIFO order. Any other thread may steal jobs from the top
+// in FIFO order.
+//
+// [......[j]jjjjjj[.].....]
+//         ^        ^
+//         |        --bottom (owner side)
+//         --top (thieves side)
+class WorkStealingDeque : public util::Noncopyable {
+    static const size_t JobAlignment = std::alignment_of<Job>::value;
+
+    Job* const _jobs;
+    const int64_t _mask;
+
+    std::atomic<int64_t> _top;
+    std::atomic<int64_t> _bottom;
+
+public:
+    template <typename Allocator>
+    WorkStealingDeque(Allocator& alloc, const size_t capacity) NOEXCEPT :
+        _jobs {static_cast<Job*>(alloc.allocate(capacity * sizeof(Job), JobAlignment, 0))},
+        _mask {static_cast<int64_t>(capacity - 1)},
+        _top {0},
+        _bottom {0}
+    {
+        assert(("Capacity must be power of two", (capacity & (capacity - 1)) == 0));
+    }
+
+    // Owner only
+    bool push(const Job& job) NOEXCEPT;
+    bool pop(Job& job) NOEXCEPT;
+
+    // Any thread
+    bool steal(Job& job) NOEXCEPT;
+
+    size_t size() const NOEXCEPT;
+};
+
+#endif // WorkStealingDeque_h__
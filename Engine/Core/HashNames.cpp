@@ -0,0 +1,54 @@
+#include "HashNames.hpp"
+
+#if !defined(NDEBUG) && !defined(_NDEBUG)
+
+#include <cstring>
+#include <thread>
+
+HashNames* HashNames::defaultInstance;
+
+HashNames::DefaultInstance::~DefaultInstance() {
+    assert(("Default instance already destroyed", defaultInstance));
+    defaultInstance->~HashNames();
+    defaultInstance = nullptr;
+}
+
+void HashNames::remember(const uint32_t hash, const char* const name, const size_t size) NOEXCEPT {
+    HashNames* const instance = defaultInstance;
+    if (!instance)
+        return;
+
+    while (instance->_lock.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    const char* const known = instance->_names.findResource(hash);
+    if (known) {
+        assert(("Different names have the same hash", strncmp(known, name, size) == 0 && !known[size]));
+    } else if (instance->_count < MaxNameCount && instance->_used + size + 1 <= StorageSize) {
+        char* const copy = instance->_storage + instance->_used;
+        memcpy(copy, name, size);
+        copy[size] = 0;
+        instance->_used += size + 1;
+        ++instance->_count;
+
+        instance->_names.registerResource(hash, copy);
+    }
+
+    instance->_lock.clear(std::memory_order_release);
+}
+
+const char* HashNames::find(const uint32_t hash) NOEXCEPT {
+    HashNames* const instance = defaultInstance;
+    if (!instance)
+        return nullptr;
+
+    while (instance->_lock.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    const char* const name = instance->_names.findResource(hash);
+
+    instance->_lock.clear(std::memory_order_release);
+    return name;
+}
+
+#endif // !defined(NDEBUG) && !defined(_NDEBUG)
@@ -0,0 +1,84 @@
+#ifndef HashNames_h__
+#define HashNames_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#include "Util/Registry.hpp"
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+// Maps name hashes back to names for diagnostics in debug builds.
+//
+// Names are remembered where both the name and its hash are known, for example
+// when a resource pack is read. Release builds keep nothing and find nothing
+class HashNames : public util::Noncopyable {
+public:
+    static const size_t MaxNameCount = 8192;
+    static const size_t StorageSize = 256 * 1024;
+
+#if !defined(NDEBUG) && !defined(_NDEBUG)
+private:
+    util::Registry<char, MaxNameCount> _names;
+    char* const _storage;
+    size_t _used;
+    size_t _count;
+
+    // Guards names and storage, loaders remember names from worker threads
+    std::atomic_flag _lock;
+
+    static HashNames* defaultInstance;
+
+    template <typename Allocator>
+    HashNames(Allocator& alloc) :
+        _names {alloc},
+        _storage {static_cast<char*>(alloc.allocate(StorageSize, 1, 0))},
+        _used {0},
+        _count {0}
+    {
+        _lock.clear();
+    }
+
+public:
+    struct DefaultInstance {
+        template <typename Allocator>
+        DefaultInstance(Allocator& alloc) {
+            assert(("Trying to initialize default instance twice", !defaultInstance));
+            void* const memory =
+                alloc.allocate(sizeof(HashNames), std::alignment_of<HashNames>::value, 0);
+            defaultInstance = new (memory) HashNames(alloc);
+        }
+        ~DefaultInstance();
+    };
+
+    // Name doesn't have to be null terminated, it is copied
+    static void remember(const uint32_t hash, const char* const name, const size_t size) NOEXCEPT;
+
+    // Returns nullptr for names which were not remembered
+    static const char* find(const uint32_t hash) NOEXCEPT;
+#else
+public:
+    struct DefaultInstance {
+        template <typename Allocator>
+        DefaultInstance(Allocator&) {}
+    };
+
+    static void remember(const uint32_t, const char* const, const size_t) NOEXCEPT {}
+
+    static const char* find(const uint32_t) NOEXCEPT {
+        return nullptr;
+    }
+#endif // !defined(NDEBUG) && !defined(_NDEBUG)
+
+    // Remembered name or a placeholder, for log messages
+    static const char* name(const uint32_t hash) NOEXCEPT {
+        const char* const name = find(hash);
+        return name ? name : "<unknown>";
+    }
+};
+
+#endif // HashNames_h__
@@ -0,0 +1,220 @@
+#include "AllocationTracker.hpp"
+
+#ifdef ENABLE_ALLOCATION_TRACKING
+
+#include <algorithm>
+
+#include "SDL_log.h"
+#include "SDL_platform.h"
+
+#ifdef __WIN32__
+#  include "SDL_windows.h"
+#else
+#  include <unwind.h>
+#endif //__WIN32__
+
+struct Stack {
+    std::atomic<uint32_t> hash;
+    std::atomic<uint32_t> depth;
+    void* frames[AllocationTracker::MaxStackDepth];
+};
+
+// Last slot collects allocations from stacks which did not fit into the table
+static const uint32_t OverflowStack = AllocationTracker::MaxStackCount - 1;
+
+// Frame of AllocationTracker::allocated, stacks are captured right in it so that inlining can't shift them
+static const size_t SkippedFrameCount = 1;
+
+static const size_t MaxReportedSiteCount = 16;
+static const size_t AgeBucketCount = 32;
+
+// Slots are claimed once and never given back, so the table can be read without locking
+static Stack stacks[AllocationTracker::MaxStackCount];
+static std::atomic<uint32_t> currentFrame {0};
+
+#ifndef __WIN32__
+struct UnwindState {
+    void** frames;
+    size_t skipped;
+    size_t depth;
+};
+
+static _Unwind_Reason_Code unwindFrame(_Unwind_Context* const context, void* const arg) {
+    auto state = static_cast<UnwindState*>(arg);
+    if (state->skipped < SkippedFrameCount) {
+        ++state->skipped;
+        return _URC_NO_REASON;
+    }
+
+    const uintptr_t address = _Unwind_GetIP(context);
+    if (!address)
+        return _URC_END_OF_STACK;
+
+    state->frames[state->depth++] = reinterpret_cast<void*>(address);
+    return state->depth < AllocationTracker::MaxStackDepth ? _URC_NO_REASON : _URC_END_OF_STACK;
+}
+#endif //__WIN32__
+
+// FNV-1a over return addresses, zero is reserved for empty slots
+static uint32_t hashStack(void* const* const frames, const size_t depth) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < depth; ++i) {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(frames[i]);
+        for (size_t byte = 0; byte < sizeof(address); ++byte) {
+            hash ^= static_cast<uint8_t>(address >> (byte * 8));
+            hash *= 16777619u;
+        }
+    }
+    return hash ? hash : 1;
+}
+
+// Stacks with the same hash are treated as the same stack
+static uint32_t findStack(const uint32_t hash, void* const* const frames, const size_t depth) {
+    uint32_t slot = hash % OverflowStack;
+    for (size_t probe = 0; probe < OverflowStack; ++probe) {
+        Stack& stack = stacks[slot];
+
+        uint32_t current = stack.hash.load(std::memory_order_acquire);
+        if (!current && stack.hash.compare_exchange_strong(current, hash, std::memory_order_acq_rel)) {
+            std::copy(frames, frames + depth, stack.frames);
+            stack.depth.store(static_cast<uint32_t>(depth), std::memory_order_release);
+            return slot;
+        }
+
+        if (current == hash)
+            return slot;
+
+        slot = (slot + 1) % OverflowStack;
+    }
+    return OverflowStack;
+}
+
+void AllocationTracker::markFrame() NOEXCEPT {
+    currentFrame.fetch_add(1, std::memory_order_relaxed);
+}
+
+AllocationTracker::Entry& AllocationTracker::entryOf(const void* const data) const NOEXCEPT {
+    const size_t index = (static_cast<const uint8_t*>(data) - _base) / _granularity;
+    assert(("Tracked memory is out of range", index < _entryCount));
+    return _entries[index];
+}
+
+void AllocationTracker::allocated(const void* const data, const size_t size) NOEXCEPT {
+    void* frames[MaxStackDepth];
+#ifdef __WIN32__
+    const size_t depth = CaptureStackBackTrace(SkippedFrameCount, MaxStackDepth, frames, nullptr);
+#else
+    UnwindState state {frames, 0, 0};
+    _Unwind_Backtrace(&unwindFrame, &state);
+    const size_t depth = state.depth;
+#endif //__WIN32__
+    const uint32_t stack = findStack(hashStack(frames, depth), frames, depth);
+
+    // entry is owned by the allocating thread until the chunk is freed
+    Entry& entry = entryOf(data);
+    entry.size.store(static_cast<uint32_t>(size), std::memory_order_relaxed);
+    entry.frame.store(currentFrame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    entry.stack.store(stack + 1, std::memory_order_release);
+}
+
+void AllocationTracker::freed(const void* const data) NOEXCEPT {
+    entryOf(data).stack.store(0, std::memory_order_relaxed);
+}
+
+size_t AllocationTracker::collectSites(Site* const sites, const size_t maxCount) const NOEXCEPT {
+    for (size_t i = 0; i < MaxStackCount; ++i)
+        _sites[i].count = 0;
+
+    for (size_t i = 0; i < _entryCount; ++i) {
+        const Entry& entry = _entries[i];
+        const uint32_t stack = entry.stack.load(std::memory_order_acquire);
+        if (!stack)
+            continue;
+
+        const uint32_t frame = entry.frame.load(std::memory_order_relaxed);
+        Site& site = _sites[stack - 1];
+        if (!site.count) {
+            site.hash = stacks[stack - 1].hash.load(std::memory_order_relaxed);
+            site.stack = stack - 1;
+            site.bytes = 0;
+            site.firstFrame = frame;
+            site.lastFrame = frame;
+        }
+
+        ++site.count;
+        site.bytes += entry.size.load(std::memory_order_relaxed);
+        site.firstFrame = std::min(site.firstFrame, frame);
+        site.lastFrame = std::max(site.lastFrame, frame);
+    }
+
+    const auto end = std::remove_if(_sites, _sites + MaxStackCount, [](const Site& site) {
+        return site.count == 0;
+    });
+    std::sort(_sites, end, [](const Site& a, const Site& b) {
+        return a.bytes > b.bytes;
+    });
+
+    const size_t count = std::min(static_cast<size_t>(end - _sites), maxCount);
+    std::copy(_sites, _sites + count, sites);
+    return count;
+}
+
+size_t AllocationTracker::stackFrames(const uint32_t stack, void* (&frames)[MaxStackDepth]) NOEXCEPT {
+    assert(("Invalid stack index", stack < MaxStackCount));
+    const size_t depth = stacks[stack].depth.load(std::memory_order_acquire);
+    std::copy(stacks[stack].frames, stacks[stack].frames + depth, frames);
+    return depth;
+}
+
+void AllocationTracker::logLiveAllocations(const char* const title) const NOEXCEPT {
+    const uint32_t frame = currentFrame.load(std::memory_order_relaxed);
+
+    // bucket 0 holds allocations of the current frame, bucket N ones from 2^(N-1) to 2^N frames old
+    size_t ages[AgeBucketCount] = {};
+    size_t totalCount = 0;
+    size_t totalBytes = 0;
+
+    for (size_t i = 0; i < _entryCount; ++i) {
+        const Entry& entry = _entries[i];
+        if (!entry.stack.load(std::memory_order_acquire))
+            continue;
+
+        uint32_t age = frame - entry.frame.load(std::memory_order_relaxed);
+        size_t bucket = 0;
+        for (; age && bucket + 1 < AgeBucketCount; age >>= 1)
+            ++bucket;
+
+        ++ages[bucket];
+        ++totalCount;
+        totalBytes += entry.size.load(std::memory_order_relaxed);
+    }
+
+    SDL_Log("%s: %u allocations, %u bytes",
+            title, static_cast<unsigned>(totalCount), static_cast<unsigned>(totalBytes));
+
+    Site sites[MaxReportedSiteCount];
+    const size_t siteCount = collectSites(sites, MaxReportedSiteCount);
+    for (size_t i = 0; i < siteCount; ++i) {
+        const Site& site = sites[i];
+        SDL_Log("  stack %08x%s: %u allocations, %u bytes, frames %u-%u",
+                site.hash, site.stack == OverflowStack ? " (overflow)" : "",
+                static_cast<unsigned>(site.count), static_cast<unsigned>(site.bytes),
+                site.firstFrame, site.lastFrame);
+
+        void* frames[MaxStackDepth];
+        const size_t depth = stackFrames(site.stack, frames);
+        for (size_t j = 0; j < depth; ++j)
+            SDL_Log("    %p", frames[j]);
+    }
+
+    for (size_t bucket = 0; bucket < AgeBucketCount; ++bucket) {
+        if (!ages[bucket])
+            continue;
+
+        const unsigned from = bucket ? 1u << (bucket - 1) : 0;
+        const unsigned to = bucket ? (1u << bucket) - 1 : 0;
+        SDL_Log("  age %u-%u frames: %u allocations", from, to, static_cast<unsigned>(ages[bucket]));
+    }
+}
+
+#endif // ENABLE_ALLOCATION_TRACKING
@@ -0,0 +1,102 @@
+#ifndef AllocationTracker_h__
+#define AllocationTracker_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+// Remembers call stack and frame of every live allocation when ENABLE_ALLOCATION_TRACKING is defined.
+//
+// Entries are kept in a side table with one entry per granularity bytes of the tracked memory,
+// so the tracked allocator layout stays the same. Call stacks are hashed and stored once in
+// a table shared by all trackers, entries refer to them by index
+class AllocationTracker : public util::Noncopyable {
+public:
+    // Number of distinct call stacks, allocations from stacks over the limit are grouped together
+    static const size_t MaxStackCount = 4096;
+    static const size_t MaxStackDepth = 8;
+
+    struct Site {
+        uint32_t hash;
+        uint32_t stack;
+        size_t count;
+        size_t bytes;
+        uint32_t firstFrame;
+        uint32_t lastFrame;
+    };
+
+#ifdef ENABLE_ALLOCATION_TRACKING
+private:
+    struct Entry {
+        std::atomic<uint32_t> stack;
+        std::atomic<uint32_t> frame;
+        std::atomic<uint32_t> size;
+    };
+
+    uint8_t* const _base;
+    const size_t _granularity;
+    const size_t _entryCount;
+    Entry* const _entries;
+
+    // Scratch for grouping sites, reports are not expected to run concurrently
+    Site* const _sites;
+
+    Entry& entryOf(const void* const data) const NOEXCEPT;
+
+public:
+    // Frame number stored with allocations made after this call
+    static void markFrame() NOEXCEPT;
+
+    template <typename Allocator>
+    AllocationTracker(Allocator& alloc, void* const base, const size_t size, const size_t granularity) :
+        _base {static_cast<uint8_t*>(base)},
+        _granularity {granularity},
+        _entryCount {size / granularity},
+        _entries {static_cast<Entry*>(
+            alloc.allocate(sizeof(Entry) * _entryCount, std::alignment_of<Entry>::value, 0))},
+        _sites {static_cast<Site*>(
+            alloc.allocate(sizeof(Site) * MaxStackCount, std::alignment_of<Site>::value, 0))}
+    {
+        for (size_t i = 0; i < _entryCount; ++i)
+            new (_entries + i) Entry {{0}, {0}, {0}};
+    }
+
+    void allocated(const void* const data, const size_t size) NOEXCEPT;
+    void freed(const void* const data) NOEXCEPT;
+
+    // Groups live allocations by call stack, returns number of sites written, biggest first
+    size_t collectSites(Site* const sites, const size_t maxCount) const NOEXCEPT;
+
+    // Stack frames of a site as return addresses, returns depth
+    static size_t stackFrames(const uint32_t stack, void* (&frames)[MaxStackDepth]) NOEXCEPT;
+
+    // Logs live allocations grouped by call stack and a histogram of their age in frames
+    void logLiveAllocations(const char* const title) const NOEXCEPT;
+#else
+    static void markFrame() NOEXCEPT {}
+
+    template <typename Allocator>
+    AllocationTracker(Allocator&, void* const, const size_t, const size_t) NOEXCEPT {}
+
+    void allocated(const void* const, const size_t) NOEXCEPT {}
+    void freed(const void* const) NOEXCEPT {}
+
+    size_t collectSites(Site* const, const size_t) const NOEXCEPT {
+        return 0;
+    }
+
+    static size_t stackFrames(const uint32_t, void* (&)[MaxStackDepth]) NOEXCEPT {
+        return 0;
+    }
+
+    void logLiveAllocations(const char* const) const NOEXCEPT {}
+#endif // ENABLE_ALLOCATION_TRACKING
+};
+
+#endif // AllocationTracker_h__
@@ -0,0 +1,73 @@
+#ifndef DebugFill_h__
+#define DebugFill_h__
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SANITIZE_ADDRESS__)
+#  define ENGINE_ADDRESS_SANITIZER
+#elif defined(__has_feature)
+#  if __has_feature(address_sanitizer)
+#    define ENGINE_ADDRESS_SANITIZER
+#  endif
+#endif
+
+#ifdef ENGINE_ADDRESS_SANITIZER
+#  include <sanitizer/asan_interface.h>
+#endif
+
+// Marks memory released by arena allocators so that using it after rewind is caught.
+//
+// With address sanitizer released ranges are poisoned and any access is reported right away,
+// committed memory starts poisoned too. Other debug builds fill released ranges with 0xDE.
+// Release builds do nothing.
+//
+// Allocators report only the ranges which were actually handed out and are still committed,
+// decommitted pages are protected by the OS anyway
+namespace DebugFill
+{
+    static const uint8_t FreedMemoryPattern = 0xDE;
+
+    inline void allocated(void* const start, const size_t size) {
+#ifdef ENGINE_ADDRESS_SANITIZER
+        ASAN_UNPOISON_MEMORY_REGION(start, size);
+#else
+        (void) start;
+        (void) size;
+#endif
+    }
+
+    inline void freed(void* const start, const size_t size) {
+#if defined(ENGINE_ADDRESS_SANITIZER)
+        ASAN_POISON_MEMORY_REGION(start, size);
+#elif !defined(NDEBUG) && !defined(_NDEBUG)
+        memset(start, FreedMemoryPattern, size);
+#else
+        (void) start;
+        (void) size;
+#endif
+    }
+
+    // Memory which becomes available to the allocator but is not handed out yet
+    inline void committed(void* const start, const size_t size) {
+#ifdef ENGINE_ADDRESS_SANITIZER
+        ASAN_POISON_MEMORY_REGION(start, size);
+#else
+        (void) start;
+        (void) size;
+#endif
+    }
+
+    // Memory which the allocator doesn't manage anymore, shadow is cleared for whoever gets it next
+    inline void decommitted(void* const start, const size_t size) {
+#ifdef ENGINE_ADDRESS_SANITIZER
+        ASAN_UNPOISON_MEMORY_REGION(start, size);
+#else
+        (void) start;
+        (void) size;
+#endif
+    }
+}
+
+#endif // DebugFill_h__
@@ -1,23 +1,152 @@
 #include "DoubleEndedLinearAllocator.hpp"
 
+#include <algorithm>
 #include <cassert>
-#include <cstring>
 
+#include "DebugFill.hpp"
 #include "Util/ptr_util.hpp"
 
-DoubleEndedLinearAllocator::DoubleEndedLinearAllocator(void* const start, void* const end) NOEXCEPT :
+DoubleEndedLinearAllocator::DoubleEndedLinearAllocator(void* const start,
+                                                       void* const end,
+                                                       const char* const name) NOEXCEPT :
     _start {static_cast<uint8_t*>(start)},
     _end {static_cast<uint8_t*>(end)},
     _current {_start},
-    _currentBack {_end}
+    _currentBack {_end},
+    _committed {_end},
+    _committedBack {_end},
+    _commitGranularity {0},
+    _telemetry {name}
 {
     assert(start <= end);
+    DebugFill::committed(_start, _end - _start);
+}
+
+DoubleEndedLinearAllocator::DoubleEndedLinearAllocator(const size_t reserveSize,
+                                                       const VirtualMemory::PageKind kind,
+                                                       const char* const name) NOEXCEPT :
+    _start {nullptr},
+    _end {nullptr},
+    _current {nullptr},
+    _currentBack {nullptr},
+    _committed {nullptr},
+    _committedBack {nullptr},
+    _commitGranularity {VirtualMemory::commitGranularity(kind)},
+    _telemetry {name}
+{
+    const size_t size = util::alignUp(reserveSize, _commitGranularity);
+
+    _start = static_cast<uint8_t*>(VirtualMemory::reserve(size, kind));
+    assert(("Could not reserve address space", _start));
+
+    _end = _start + size;
+    _current = _start;
+    _currentBack = _end;
+    _committed = _start;
+    _committedBack = _end;
+}
+
+DoubleEndedLinearAllocator::~DoubleEndedLinearAllocator() {
+    DebugFill::decommitted(_start, std::min(_committed, _committedBack) - _start);
+    DebugFill::decommitted(_committedBack, _end - _committedBack);
+
+    if (_commitGranularity)
+        VirtualMemory::release(_start, _end - _start);
+}
+
+// Front and back committed ranges may overlap when both ends meet in the same granule,
+// memory is committed and decommitted only outside of the range committed by the other end
+
+void DoubleEndedLinearAllocator::commit(uint8_t* const end) NOEXCEPT {
+    if (!_commitGranularity || end <= _committed)
+        return;
+
+    uint8_t* const committed = std::min(util::alignUp(end, _commitGranularity), _end);
+    uint8_t* const commitEnd = std::min(committed, _committedBack);
+    if (_committed < commitEnd) {
+        const bool succeeded = VirtualMemory::commit(_committed, commitEnd - _committed);
+        assert(("Out of memory", succeeded));
+        DebugFill::committed(_committed, commitEnd - _committed);
+    }
+
+    _committed = committed;
+}
+
+void DoubleEndedLinearAllocator::commitBack(uint8_t* const start) NOEXCEPT {
+    if (!_commitGranularity || start >= _committedBack)
+        return;
+
+    uint8_t* const committed = util::alignDown(start, _commitGranularity);
+    uint8_t* const commitStart = std::max(committed, _committed);
+    if (commitStart < _committedBack) {
+        const bool succeeded = VirtualMemory::commit(commitStart, _committedBack - commitStart);
+        assert(("Out of memory", succeeded));
+        DebugFill::committed(commitStart, _committedBack - commitStart);
+    }
+
+    _committedBack = committed;
+}
+
+// One extra granule stays committed so that allocations hovering
+// around a granule boundary don't commit and decommit it every time
+void DoubleEndedLinearAllocator::decommit(uint8_t* const end) NOEXCEPT {
+    if (!_commitGranularity)
+        return;
+
+    uint8_t* const committed = util::alignUp(end, _commitGranularity) + _commitGranularity;
+    if (committed >= _committed)
+        return;
+
+    uint8_t* const decommitEnd = std::min(_committed, _committedBack);
+    if (committed < decommitEnd) {
+        DebugFill::decommitted(committed, decommitEnd - committed);
+        VirtualMemory::decommit(committed, decommitEnd - committed);
+    }
+
+    _committed = committed;
+}
+
+void DoubleEndedLinearAllocator::decommitBack(uint8_t* const start) NOEXCEPT {
+    if (!_commitGranularity)
+        return;
+
+    uint8_t* const aligned = util::alignDown(start, _commitGranularity);
+    if (aligned <= _start + _commitGranularity)
+        return;
+
+    uint8_t* const committed = aligned - _commitGranularity;
+    if (committed <= _committedBack)
+        return;
+
+    uint8_t* const decommitStart = std::max(_committedBack, _committed);
+    if (decommitStart < committed) {
+        DebugFill::decommitted(decommitStart, committed - decommitStart);
+        VirtualMemory::decommit(decommitStart, committed - decommitStart);
+    }
+
+    _committedBack = committed;
+}
+
+// Memory past the old top of either end was filled when it was released before,
+// so only the released range needs it. Pages given back to the OS are protected anyway
+void DoubleEndedLinearAllocator::fillReleased(uint8_t* const start, uint8_t* const end) NOEXCEPT {
+    uint8_t* const frontEnd = std::min(end, _committed);
+    if (start < frontEnd)
+        DebugFill::freed(start, frontEnd - start);
+
+    // ends may meet in a granule committed by the back end only
+    uint8_t* const backStart = std::max(std::max(start, _committedBack), frontEnd);
+    if (backStart < end)
+        DebugFill::freed(backStart, end - backStart);
 }
 
 void* DoubleEndedLinearAllocator::allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT {
     uint8_t* const aligned =
         util::alignUp(_current + offset, alignment) - offset;
     assert(aligned + size < _currentBack);
+    commit(aligned + size);
+    DebugFill::allocated(aligned, size);
+    _telemetry.allocated(aligned + size - _current);
     _current = aligned + size;
     return aligned;
 }
@@ -26,17 +155,16 @@ void* DoubleEndedLinearAllocator::allocateBack(const size_t size, const size_t a
     uint8_t* const aligned =
         util::alignDown(_currentBack - size, alignment) - offset;
     assert(aligned > _current);
+    commitBack(aligned);
+    DebugFill::allocated(aligned, size);
+    _telemetry.allocated(_currentBack - aligned);
     _currentBack = aligned;
     return aligned;
 }
 
 void DoubleEndedLinearAllocator::reset() NOEXCEPT {
-#if !defined(NDEBUG) && !defined(_NDEBUG)
-    memset(_start, 0xDE, _end - _start);
-#endif
-
-    _current = _start;
-    _currentBack = _end;
+    rewind(reinterpret_cast<RewindMarker>(_start));
+    rewindBack(reinterpret_cast<RewindMarker>(_end));
 }
 
 DoubleEndedLinearAllocator::RewindMarker DoubleEndedLinearAllocator::rewindMarker() const NOEXCEPT {
@@ -51,20 +179,31 @@ void DoubleEndedLinearAllocator::rewind(const RewindMarker marker) NOEXCEPT {
     uint8_t* const rewindPoint = reinterpret_cast<uint8_t*>(marker);
     assert(_start <= rewindPoint && rewindPoint <= _current);
 
-#if !defined(NDEBUG) && !defined(_NDEBUG)
-    memset(rewindPoint, 0xDE, _current - rewindPoint);
-#endif
+    _telemetry.freed(_current - rewindPoint);
 
+    uint8_t* const current = _current;
     _current = rewindPoint;
+    decommit(_current);
+    fillReleased(rewindPoint, current);
 }
 
 void DoubleEndedLinearAllocator::rewindBack(const RewindMarker marker) NOEXCEPT {
     uint8_t* const rewindPoint = reinterpret_cast<uint8_t*>(marker);
     assert(_currentBack <= rewindPoint && rewindPoint <= _end);
 
-#if !defined(NDEBUG) && !defined(_NDEBUG)
-    memset(_currentBack, 0xDE, rewindPoint - _currentBack);
-#endif
+    _telemetry.freed(rewindPoint - _currentBack);
 
+    uint8_t* const currentBack = _currentBack;
     _currentBack = rewindPoint;
+    decommitBack(_currentBack);
+    fillReleased(currentBack, rewindPoint);
+}
+
+size_t DoubleEndedLinearAllocator::reservedSize() const NOEXCEPT {
+    return _end - _start;
+}
+
+size_t DoubleEndedLinearAllocator::committedSize() const NOEXCEPT {
+    const size_t overlap = _committed > _committedBack ? _committed - _committedBack : 0;
+    return (_committed - _start) + (_end - _committedBack) - overlap;
 }
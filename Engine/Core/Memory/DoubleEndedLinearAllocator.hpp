@@ -3,6 +3,8 @@
 
 #include <cstdlib>
 
+#include "MemoryTelemetry.hpp"
+#include "VirtualMemory.hpp"
 #include "Util/defines.hpp"
 #include "Util/noncopyable.hpp"
 
@@ -12,10 +14,34 @@ class DoubleEndedLinearAllocator : public util::Noncopyable {
     uint8_t* _current;
     uint8_t* _currentBack;
 
+    // Memory between these points is only reserved
+    uint8_t* _committed;
+    uint8_t* _committedBack;
+
+    // Zero when allocator works over a buffer it doesn't own
+    size_t _commitGranularity;
+
+    AllocatorTelemetry _telemetry;
+
+    void commit(uint8_t* const end) NOEXCEPT;
+    void commitBack(uint8_t* const start) NOEXCEPT;
+    void decommit(uint8_t* const end) NOEXCEPT;
+    void decommitBack(uint8_t* const start) NOEXCEPT;
+    void fillReleased(uint8_t* const start, uint8_t* const end) NOEXCEPT;
+
 public:
     typedef size_t RewindMarker;
 
-    DoubleEndedLinearAllocator(void* const start, void* const end) NOEXCEPT;
+    DoubleEndedLinearAllocator(void* const start,
+                               void* const end,
+                               const char* const name = "DoubleEndedLinearAllocator") NOEXCEPT;
+
+    // Reserves address space and commits it from both ends as allocations advance,
+    // rewinding and resetting give the memory back to the OS
+    explicit DoubleEndedLinearAllocator(const size_t reserveSize,
+                                        const VirtualMemory::PageKind kind = VirtualMemory::NormalPages,
+                                        const char* const name = "DoubleEndedLinearAllocator") NOEXCEPT;
+    ~DoubleEndedLinearAllocator();
 
     void* allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT;
     void* allocateBack(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT;
@@ -26,6 +52,9 @@ public:
     void rewindBack(const RewindMarker marker) NOEXCEPT;
 
     void reset() NOEXCEPT;
+
+    size_t reservedSize() const NOEXCEPT;
+    size_t committedSize() const NOEXCEPT;
 };
 
 #endif // DoubleEndedLinearAllocator_h__
@@ -0,0 +1,64 @@
+#include "FrameAllocator.hpp"
+
+#include "Util/ptr_util.hpp"
+
+FrameAllocator* FrameAllocator::DefaultInstance::defaultInstance;
+
+FrameAllocator::DefaultInstance::~DefaultInstance() {
+    assert(("Default instance already destroyed", defaultInstance));
+    defaultInstance->~FrameAllocator();
+    defaultInstance = nullptr;
+}
+
+FrameAllocator& FrameAllocator::getDefault() {
+    return *DefaultInstance::defaultInstance;
+}
+
+FrameAllocator::~FrameAllocator() {
+    for (size_t i = 0; i < _bufferCount; ++i)
+        DebugFill::decommitted(_buffers[i].start, _bufferSize);
+}
+
+void* FrameAllocator::allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT {
+    const uint64_t frame = _frame.load(std::memory_order_acquire);
+    Buffer& buffer = _buffers[frame % _bufferCount];
+
+    size_t used = buffer.used.load(std::memory_order_relaxed);
+    size_t newUsed;
+    uint8_t* aligned;
+    do {
+        aligned = util::alignUp(buffer.start + used + offset, alignment) - offset;
+        newUsed = aligned + size - buffer.start;
+        assert(("Frame allocator buffer is exhausted", newUsed <= _bufferSize));
+    } while (!buffer.used.compare_exchange_weak(used, newUsed, std::memory_order_relaxed));
+
+    assert(("Allocation was held across a reset of its buffer",
+            _frame.load(std::memory_order_relaxed) - frame < _bufferCount));
+
+    DebugFill::allocated(aligned, size);
+    _telemetry.allocated(newUsed - used);
+    return aligned;
+}
+
+void FrameAllocator::nextFrame() NOEXCEPT {
+    const uint64_t frame = _frame.load(std::memory_order_relaxed) + 1;
+
+    // the buffer was last used latency + 1 frames ago
+    Buffer& buffer = _buffers[frame % _bufferCount];
+    // an allocation racing with the reset either lands in the exchanged range or starts anew,
+    // it is never handed out twice
+    const size_t used = buffer.used.exchange(0, std::memory_order_relaxed);
+
+    DebugFill::freed(buffer.start, used);
+    _telemetry.freed(used);
+
+    _frame.store(frame, std::memory_order_release);
+}
+
+uint64_t FrameAllocator::frame() const NOEXCEPT {
+    return _frame.load(std::memory_order_acquire);
+}
+
+size_t FrameAllocator::latency() const NOEXCEPT {
+    return _bufferCount - 1;
+}
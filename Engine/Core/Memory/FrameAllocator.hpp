@@ -0,0 +1,97 @@
+#ifndef FrameAllocator_h__
+#define FrameAllocator_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+
+#include "DebugFill.hpp"
+#include "MemoryTelemetry.hpp"
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+// Allocator for data handed from one frame to another, for example from update to render
+// or from a job to the main thread.
+//
+// Memory allocated during frame N stays valid until the end of frame N + latency,
+// there are latency + 1 buffers and every nextFrame call resets the oldest one.
+// Allocation can be done from any thread, nextFrame is called by the main loop only.
+//
+// An allocate call picks its buffer by the frame it read on entry. If nextFrame runs
+// latency + 1 times before the call returns, that buffer is reset under it, so an allocation
+// must never be held across that many frames. Debug builds assert on it
+class FrameAllocator : public util::Noncopyable {
+public:
+    static const size_t MaxLatency = 3;
+
+private:
+    struct Buffer {
+        uint8_t* start;
+        std::atomic<size_t> used;
+    };
+
+    const size_t _bufferSize;
+    const size_t _bufferCount;
+    std::atomic<uint64_t> _frame;
+
+    Buffer _buffers[MaxLatency + 1];
+
+    AllocatorTelemetry _telemetry;
+
+public:
+    struct DefaultInstance {
+        static FrameAllocator* defaultInstance;
+
+        static const size_t DefaultBufferSize = 1024 * 1024;
+        static const size_t DefaultLatency = 1;
+
+        template <typename Allocator>
+        DefaultInstance(Allocator& alloc) {
+            assert(("Trying to initialize default instance twice", !defaultInstance));
+            void* const memory =
+                alloc.allocate(sizeof(FrameAllocator), std::alignment_of<FrameAllocator>::value, 0);
+            defaultInstance = new (memory) FrameAllocator(alloc, DefaultBufferSize, DefaultLatency);
+        }
+        ~DefaultInstance();
+    };
+
+    static FrameAllocator& getDefault();
+
+    template <typename Allocator>
+    FrameAllocator(Allocator& alloc,
+                   const size_t bufferSize,
+                   const size_t latency,
+                   const char* const name = "FrameAllocator") :
+        _bufferSize {bufferSize},
+        _bufferCount {latency + 1},
+        _frame {0},
+        _telemetry {name}
+    {
+        assert(("Latency is too big", latency <= MaxLatency));
+
+        for (size_t i = 0; i < _bufferCount; ++i) {
+            _buffers[i].start = static_cast<uint8_t*>(alloc.allocate(bufferSize, 16, 0));
+            _buffers[i].used.store(0, std::memory_order_relaxed);
+            DebugFill::committed(_buffers[i].start, bufferSize);
+        }
+    }
+
+    ~FrameAllocator();
+
+    void* allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT;
+
+    template <typename T>
+    T* createPODArray(const size_t count) NOEXCEPT {
+        return static_cast<T*>(allocate(sizeof(T) * count, std::alignment_of<T>::value, 0));
+    }
+
+    // Starts a new frame, memory allocated latency + 1 frames ago becomes invalid
+    void nextFrame() NOEXCEPT;
+
+    uint64_t frame() const NOEXCEPT;
+    size_t latency() const NOEXCEPT;
+};
+
+#endif // FrameAllocator_h__
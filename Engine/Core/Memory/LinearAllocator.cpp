@@ -1,32 +1,90 @@
 #include "LinearAllocator.hpp"
 
+#include <algorithm>
 #include <cassert>
-#include <cstring>
 
+#include "DebugFill.hpp"
 #include "Util/ptr_util.hpp"
 
-LinearAllocator::LinearAllocator(void* const start, void* const end) NOEXCEPT :
+LinearAllocator::LinearAllocator(void* const start, void* const end, const char* const name) NOEXCEPT :
     _start {static_cast<uint8_t*>(start)},
     _end {static_cast<uint8_t*>(end)},
-    _current {_start}
+    _current {_start},
+    _committed {_end},
+    _commitGranularity {0},
+    _telemetry {name}
 {
     assert(start <= end);
+    DebugFill::committed(_start, _end - _start);
+}
+
+LinearAllocator::LinearAllocator(const size_t reserveSize,
+                                 const VirtualMemory::PageKind kind,
+                                 const char* const name) NOEXCEPT :
+    _start {nullptr},
+    _end {nullptr},
+    _current {nullptr},
+    _committed {nullptr},
+    _commitGranularity {VirtualMemory::commitGranularity(kind)},
+    _telemetry {name}
+{
+    const size_t size = util::alignUp(reserveSize, _commitGranularity);
+
+    _start = static_cast<uint8_t*>(VirtualMemory::reserve(size, kind));
+    assert(("Could not reserve address space", _start));
+
+    _end = _start + size;
+    _current = _start;
+    _committed = _start;
+}
+
+LinearAllocator::~LinearAllocator() {
+    DebugFill::decommitted(_start, _committed - _start);
+
+    if (_commitGranularity)
+        VirtualMemory::release(_start, _end - _start);
+}
+
+void LinearAllocator::commit(uint8_t* const end) NOEXCEPT {
+    if (!_commitGranularity || end <= _committed)
+        return;
+
+    uint8_t* const committed = std::min(util::alignUp(end, _commitGranularity), _end);
+    const bool succeeded = VirtualMemory::commit(_committed, committed - _committed);
+    assert(("Out of memory", succeeded));
+    DebugFill::committed(_committed, committed - _committed);
+
+    _committed = committed;
+}
+
+// One extra granule stays committed so that allocations hovering
+// around a granule boundary don't commit and decommit it every time
+void LinearAllocator::decommit(uint8_t* const end) NOEXCEPT {
+    if (!_commitGranularity)
+        return;
+
+    uint8_t* const committed = util::alignUp(end, _commitGranularity) + _commitGranularity;
+    if (committed >= _committed)
+        return;
+
+    DebugFill::decommitted(committed, _committed - committed);
+    VirtualMemory::decommit(committed, _committed - committed);
+    _committed = committed;
 }
 
 void* LinearAllocator::allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT {
     uint8_t* const aligned =
         util::alignUp(_current + offset, alignment) - offset;
     assert(aligned + size < _end);
+    commit(aligned + size);
+    DebugFill::allocated(aligned, size);
+    _telemetry.allocated(aligned + size - _current);
     _current = aligned + size;
     return aligned;
 }
 
 void LinearAllocator::reset() NOEXCEPT {
-#if !defined(NDEBUG) && !defined(_NDEBUG)
-    memset(_start, 0xDE, _end - _start);
-#endif
-
-    _current = _start;
+    rewind(reinterpret_cast<RewindMarker>(_start));
 }
 
 LinearAllocator::RewindMarker LinearAllocator::rewindMarker() const NOEXCEPT {
@@ -37,9 +95,21 @@ void LinearAllocator::rewind(const RewindMarker marker) NOEXCEPT {
     uint8_t* const rewindPoint = reinterpret_cast<uint8_t*>(marker);
     assert(_start <= rewindPoint && rewindPoint <= _current);
 
-#if !defined(NDEBUG) && !defined(_NDEBUG)
-    memset(rewindPoint, 0xDE, _current - rewindPoint);
-#endif
+    _telemetry.freed(_current - rewindPoint);
 
+    uint8_t* const current = _current;
     _current = rewindPoint;
+    decommit(_current);
+
+    // memory past the old top was filled when it was released before,
+    // so only the released range which is still committed needs it
+    DebugFill::freed(rewindPoint, std::min(current, _committed) - rewindPoint);
+}
+
+size_t LinearAllocator::reservedSize() const NOEXCEPT {
+    return _end - _start;
+}
+
+size_t LinearAllocator::committedSize() const NOEXCEPT {
+    return _committed - _start;
 }
@@ -3,6 +3,8 @@
 
 #include <cstdlib>
 
+#include "MemoryTelemetry.hpp"
+#include "VirtualMemory.hpp"
 #include "Util/defines.hpp"
 #include "Util/noncopyable.hpp"
 
@@ -11,10 +13,28 @@ class LinearAllocator : public util::Noncopyable {
     uint8_t* _end;
     uint8_t* _current;
 
+    // Memory past this point is only reserved
+    uint8_t* _committed;
+
+    // Zero when allocator works over a buffer it doesn't own
+    size_t _commitGranularity;
+
+    AllocatorTelemetry _telemetry;
+
+    void commit(uint8_t* const end) NOEXCEPT;
+    void decommit(uint8_t* const end) NOEXCEPT;
+
 public:
     typedef size_t RewindMarker;
 
-    LinearAllocator(void* const start, void* const end) NOEXCEPT;
+    LinearAllocator(void* const start, void* const end, const char* const name = "LinearAllocator") NOEXCEPT;
+
+    // Reserves address space and commits it as allocations advance,
+    // rewinding and resetting give the memory back to the OS
+    explicit LinearAllocator(const size_t reserveSize,
+                             const VirtualMemory::PageKind kind = VirtualMemory::NormalPages,
+                             const char* const name = "LinearAllocator") NOEXCEPT;
+    ~LinearAllocator();
 
     void* allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT;
 
@@ -22,6 +42,9 @@ public:
     void rewind(const RewindMarker marker) NOEXCEPT;
 
     void reset() NOEXCEPT;
+
+    size_t reservedSize() const NOEXCEPT;
+    size_t committedSize() const NOEXCEPT;
 };
 
 #endif // LinearAllocator_h__
@@ -0,0 +1,209 @@
+#include "MemoryTelemetry.hpp"
+
+#ifdef ENABLE_MEMORY_TELEMETRY
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "Core/String.hpp"
+#include "IO/FileUtils.h"
+#include "IO/Stream.hpp"
+
+struct MemoryTelemetry::Record {
+    std::atomic<const char*> name;
+    std::atomic<size_t> inUse;
+    std::atomic<size_t> peak;
+    std::atomic<size_t> framePeak;
+    std::atomic<uint64_t> allocationCount;
+    std::atomic<uint64_t> freeCount;
+};
+
+struct Tag {
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> allocatedBytes;
+    std::atomic<uint64_t> allocationCount;
+};
+
+static const size_t MaxFrameCount = 1024;
+static const size_t LineBufferSize = 256;
+
+// Slots are claimed in order and never given back, so tables can be read without locking
+static MemoryTelemetry::Record records[MemoryTelemetry::MaxAllocatorCount];
+static Tag tags[MemoryTelemetry::MaxTagCount];
+
+// Written by the thread that marks frames only
+static size_t timeline[MaxFrameCount][MemoryTelemetry::MaxAllocatorCount];
+static size_t frameCount = 0;
+
+static thread_local const char* currentTag = nullptr;
+
+template <typename T>
+static void updateMax(std::atomic<T>& maximum, const T value) {
+    T current = maximum.load(std::memory_order_relaxed);
+    while (current < value && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+// Finds slot with the given name or claims the first free one
+template <typename T, size_t N>
+static T* findSlot(T (&slots)[N], const char* const name) {
+    for (size_t i = 0; i < N; ++i) {
+        const char* slotName = slots[i].name.load(std::memory_order_acquire);
+        if (!slotName && slots[i].name.compare_exchange_strong(slotName, name, std::memory_order_acq_rel))
+            return &slots[i];
+
+        // pointer comparison catches the common case of the same literal
+        if (slotName == name || strcmp(slotName, name) == 0)
+            return &slots[i];
+    }
+    return nullptr;
+}
+
+MemoryTelemetry::Record* MemoryTelemetry::findRecord(const char* const name) NOEXCEPT {
+    return findSlot(records, name);
+}
+
+void MemoryTelemetry::recordAllocation(Record* const record, const size_t size) NOEXCEPT {
+    if (record) {
+        const size_t inUse = record->inUse.fetch_add(size, std::memory_order_relaxed) + size;
+        updateMax(record->peak, inUse);
+        updateMax(record->framePeak, inUse);
+        record->allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!currentTag)
+        return;
+
+    Tag* const tag = findSlot(tags, currentTag);
+    if (tag) {
+        tag->allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        tag->allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MemoryTelemetry::recordFree(Record* const record, const size_t size) NOEXCEPT {
+    if (!record || !size)
+        return;
+
+    record->inUse.fetch_sub(size, std::memory_order_relaxed);
+    record->freeCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+const char* MemoryTelemetry::setTag(const char* const tag) NOEXCEPT {
+    const char* const previous = currentTag;
+    currentTag = tag;
+    return previous;
+}
+
+void MemoryTelemetry::snapshot(Snapshot& snapshot) NOEXCEPT {
+    snapshot.allocatorCount = 0;
+    for (const Record& record : records) {
+        const char* const name = record.name.load(std::memory_order_acquire);
+        if (!name)
+            break;
+
+        AllocatorStats& stats = snapshot.allocators[snapshot.allocatorCount++];
+        stats.name = name;
+        stats.inUse = record.inUse.load(std::memory_order_relaxed);
+        stats.peak = record.peak.load(std::memory_order_relaxed);
+        stats.allocationCount = record.allocationCount.load(std::memory_order_relaxed);
+        stats.freeCount = record.freeCount.load(std::memory_order_relaxed);
+    }
+
+    snapshot.tagCount = 0;
+    for (const Tag& tag : tags) {
+        const char* const name = tag.name.load(std::memory_order_acquire);
+        if (!name)
+            break;
+
+        TagStats& stats = snapshot.tags[snapshot.tagCount++];
+        stats.name = name;
+        stats.allocatedBytes = tag.allocatedBytes.load(std::memory_order_relaxed);
+        stats.allocationCount = tag.allocationCount.load(std::memory_order_relaxed);
+    }
+}
+
+void MemoryTelemetry::markFrame() NOEXCEPT {
+    size_t* const frame = timeline[frameCount % MaxFrameCount];
+
+    for (size_t i = 0; i < MaxAllocatorCount; ++i) {
+        Record& record = records[i];
+        if (!record.name.load(std::memory_order_acquire)) {
+            frame[i] = 0;
+            continue;
+        }
+
+        // next frame starts from what is in use right now
+        const size_t inUse = record.inUse.load(std::memory_order_relaxed);
+        frame[i] = std::max(record.framePeak.exchange(inUse, std::memory_order_relaxed), inUse);
+    }
+
+    ++frameCount;
+}
+
+bool MemoryTelemetry::dumpTimeline(const char* const fileName) {
+    Stream stream = Stream::fromFile(FileUtils::writableDataPath(fileName), "wb");
+    if (!stream.isValid())
+        return false;
+
+    char line[LineBufferSize];
+
+    size_t recordCount = 0;
+    stream.writeFrom(reinterpret_cast<const uint8_t*>("frame"), 5);
+    for (; recordCount < MaxAllocatorCount; ++recordCount) {
+        const char* const name = records[recordCount].name.load(std::memory_order_acquire);
+        if (!name)
+            break;
+
+        const int length = snprintf(line, LineBufferSize, ",%s", name);
+        stream.writeFrom(reinterpret_cast<const uint8_t*>(line), static_cast<size_t>(length));
+    }
+    stream.writeFrom(reinterpret_cast<const uint8_t*>("\n"), 1);
+
+    const size_t first = frameCount > MaxFrameCount ? frameCount - MaxFrameCount : 0;
+    for (size_t frame = first; frame < frameCount; ++frame) {
+        const size_t* const peaks = timeline[frame % MaxFrameCount];
+
+        int length = snprintf(line, LineBufferSize, "%u", static_cast<unsigned>(frame));
+        stream.writeFrom(reinterpret_cast<const uint8_t*>(line), static_cast<size_t>(length));
+
+        for (size_t i = 0; i < recordCount; ++i) {
+            length = snprintf(line, LineBufferSize, ",%u", static_cast<unsigned>(peaks[i]));
+            stream.writeFrom(reinterpret_cast<const uint8_t*>(line), static_cast<size_t>(length));
+        }
+        stream.writeFrom(reinterpret_cast<const uint8_t*>("\n"), 1);
+    }
+
+    return true;
+}
+
+#else
+
+MemoryTelemetry::Record* MemoryTelemetry::findRecord(const char* const) NOEXCEPT {
+    return nullptr;
+}
+
+void MemoryTelemetry::recordAllocation(Record* const, const size_t) NOEXCEPT {
+}
+
+void MemoryTelemetry::recordFree(Record* const, const size_t) NOEXCEPT {
+}
+
+const char* MemoryTelemetry::setTag(const char* const) NOEXCEPT {
+    return nullptr;
+}
+
+void MemoryTelemetry::snapshot(Snapshot& snapshot) NOEXCEPT {
+    snapshot.allocatorCount = 0;
+    snapshot.tagCount = 0;
+}
+
+void MemoryTelemetry::markFrame() NOEXCEPT {
+}
+
+bool MemoryTelemetry::dumpTimeline(const char* const) {
+    return false;
+}
+
+#endif // ENABLE_MEMORY_TELEMETRY
@@ -0,0 +1,119 @@
+#ifndef MemoryTelemetry_h__
+#define MemoryTelemetry_h__
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+// Allocator statistics collected when ENABLE_MEMORY_TELEMETRY is defined.
+//
+// Allocators report to records shared by name, so every ScopeStack named "Frame scope"
+// adds up to a single record that outlives them. Allocations may be tagged with MEMORY_TAG,
+// tags count allocated bytes only since linear allocators free memory in bulk.
+// Allocators stacked on each other (ScopeStack over LinearAllocator) add to a tag at every level
+namespace MemoryTelemetry
+{
+    static const size_t MaxAllocatorCount = 32;
+    static const size_t MaxTagCount = 64;
+
+    struct AllocatorStats {
+        const char* name;
+        size_t inUse;
+        size_t peak;
+        uint64_t allocationCount;
+        uint64_t freeCount;
+    };
+
+    struct TagStats {
+        const char* name;
+        uint64_t allocatedBytes;
+        uint64_t allocationCount;
+    };
+
+    struct Snapshot {
+        AllocatorStats allocators[MaxAllocatorCount];
+        size_t allocatorCount;
+        TagStats tags[MaxTagCount];
+        size_t tagCount;
+    };
+
+    struct Record;
+
+    // Both return nullptr when telemetry is compiled out or the table is full
+    Record* findRecord(const char* const name) NOEXCEPT;
+
+    void recordAllocation(Record* const record, const size_t size) NOEXCEPT;
+    void recordFree(Record* const record, const size_t size) NOEXCEPT;
+
+    // Sets tag of the calling thread, returns the previous one
+    const char* setTag(const char* const tag) NOEXCEPT;
+
+    void snapshot(Snapshot& snapshot) NOEXCEPT;
+
+    // Samples peak usage of every allocator since the previous frame mark
+    void markFrame() NOEXCEPT;
+
+    // Writes per-frame peaks as CSV into the writable folder, one column per allocator
+    bool dumpTimeline(const char* const fileName);
+}
+
+// Per-allocator instance part of the telemetry, empty unless ENABLE_MEMORY_TELEMETRY is defined
+class AllocatorTelemetry : public util::Noncopyable {
+#ifdef ENABLE_MEMORY_TELEMETRY
+    MemoryTelemetry::Record* const _record;
+    std::atomic<size_t> _inUse;
+#endif // ENABLE_MEMORY_TELEMETRY
+
+public:
+#ifdef ENABLE_MEMORY_TELEMETRY
+    explicit AllocatorTelemetry(const char* const name) NOEXCEPT :
+        _record {MemoryTelemetry::findRecord(name)},
+        _inUse {0}
+    {}
+
+    ~AllocatorTelemetry() {
+        MemoryTelemetry::recordFree(_record, _inUse.load(std::memory_order_relaxed));
+    }
+
+    void allocated(const size_t size) NOEXCEPT {
+        _inUse.fetch_add(size, std::memory_order_relaxed);
+        MemoryTelemetry::recordAllocation(_record, size);
+    }
+
+    void freed(const size_t size) NOEXCEPT {
+        _inUse.fetch_sub(size, std::memory_order_relaxed);
+        MemoryTelemetry::recordFree(_record, size);
+    }
+#else
+    explicit AllocatorTelemetry(const char* const) NOEXCEPT {}
+
+    void allocated(const size_t) NOEXCEPT {}
+    void freed(const size_t) NOEXCEPT {}
+#endif // ENABLE_MEMORY_TELEMETRY
+};
+
+class MemoryTag : public util::Noncopyable {
+    const char* const _previous;
+
+public:
+    explicit MemoryTag(const char* const tag) NOEXCEPT :
+        _previous {MemoryTelemetry::setTag(tag)}
+    {}
+
+    ~MemoryTag() {
+        MemoryTelemetry::setTag(_previous);
+    }
+};
+
+#ifdef ENABLE_MEMORY_TELEMETRY
+#  define MEMORY_TAG_CONCAT_IMPL(a, b) a##b
+#  define MEMORY_TAG_CONCAT(a, b) MEMORY_TAG_CONCAT_IMPL(a, b)
+#  define MEMORY_TAG(name) const MemoryTag MEMORY_TAG_CONCAT(memoryTag, __LINE__)(name)
+#else
+#  define MEMORY_TAG(name) ((void)0)
+#endif // ENABLE_MEMORY_TELEMETRY
+
+#endif // MemoryTelemetry_h__
@@ -5,6 +5,7 @@
 #include <type_traits>
 #include <utility>
 
+#include "MemoryTelemetry.hpp"
 #include "Util/defines.hpp"
 #include "Util/noncopyable.hpp"
 
@@ -25,6 +26,7 @@ class ScopeStack : public util::Noncopyable {
     Allocator& _alloc;
     const RewindMarker _rewindPoint;
     Finalizer* _finalizerChain;
+    AllocatorTelemetry _telemetry;
 
     Finalizer* allocateWithFinalizer(const size_t size, const size_t alignment) NOEXCEPT {
         void* const memory =
@@ -37,10 +39,11 @@ class ScopeStack : public util::Noncopyable {
     }
 
 public:
-    explicit ScopeStack(Allocator& alloc) NOEXCEPT :
+    explicit ScopeStack(Allocator& alloc, const char* const name = "ScopeStack") NOEXCEPT :
         _alloc(alloc),
         _rewindPoint(alloc.rewindMarker()),
-        _finalizerChain(nullptr)
+        _finalizerChain(nullptr),
+        _telemetry(name)
     {}
 
     ~ScopeStack() {
@@ -52,6 +55,7 @@ public:
     }
 
     void* allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT {
+        _telemetry.allocated(size);
         return _alloc.allocate(size, alignment, offset);
     }
 
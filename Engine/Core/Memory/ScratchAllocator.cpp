@@ -0,0 +1,201 @@
+#include "ScratchAllocator.hpp"
+
+#include <thread>
+
+#include "DebugFill.hpp"
+#include "VirtualMemory.hpp"
+#include "Util/ptr_util.hpp"
+
+// Placed at the start of every block, links free blocks while they are in the pool
+struct ScratchBlock {
+    ScratchBlock* previous;
+    size_t base;
+};
+
+static const size_t BlockHeaderSize = util::alignUp(sizeof(ScratchBlock), 16);
+
+inline static uint8_t* blockStart(ScratchBlock* const block) {
+    return reinterpret_cast<uint8_t*>(block) + BlockHeaderSize;
+}
+
+inline static uint8_t* blockEnd(ScratchBlock* const block) {
+    return reinterpret_cast<uint8_t*>(block) + ScratchBlockPool::BlockSize;
+}
+
+ScratchBlockPool* ScratchBlockPool::DefaultInstance::defaultInstance;
+
+ScratchBlockPool::DefaultInstance::~DefaultInstance() {
+    assert(("Default instance already destroyed", defaultInstance));
+    defaultInstance->~ScratchBlockPool();
+    defaultInstance = nullptr;
+}
+
+ScratchBlockPool& ScratchBlockPool::getDefault() {
+    return *DefaultInstance::defaultInstance;
+}
+
+ScratchBlockPool::ScratchBlockPool(const size_t maxBlockCount) NOEXCEPT :
+    _memory {static_cast<uint8_t*>(VirtualMemory::reserve(maxBlockCount * BlockSize, VirtualMemory::NormalPages))},
+    _maxBlockCount {maxBlockCount},
+    _usedBlockCount {0},
+    _freeBlocks {nullptr}
+{
+    assert(("Could not reserve address space", _memory));
+    assert(("Block size must be a multiple of page size", BlockSize % VirtualMemory::pageSize() == 0));
+    _lock.clear();
+}
+
+ScratchBlockPool::~ScratchBlockPool() {
+    size_t freeBlockCount = 0;
+    for (ScratchBlock* block = _freeBlocks; block; block = block->previous)
+        ++freeBlockCount;
+    assert(("Scratch blocks are still in use", freeBlockCount == _usedBlockCount));
+
+    DebugFill::decommitted(_memory, _usedBlockCount * BlockSize);
+    VirtualMemory::release(_memory, _maxBlockCount * BlockSize);
+}
+
+ScratchBlock* ScratchBlockPool::acquire() NOEXCEPT {
+    while (_lock.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    ScratchBlock* block = _freeBlocks;
+    bool committed = true;
+    if (block) {
+        _freeBlocks = block->previous;
+    } else if (_usedBlockCount < _maxBlockCount) {
+        block = reinterpret_cast<ScratchBlock*>(_memory + _usedBlockCount * BlockSize);
+        ++_usedBlockCount;
+        committed = false;
+    }
+
+    _lock.clear(std::memory_order_release);
+
+    // new blocks are committed outside of the lock, nobody else can see them yet
+    if (!committed) {
+        const bool succeeded = VirtualMemory::commit(block, BlockSize);
+        assert(("Out of memory", succeeded));
+        DebugFill::committed(blockStart(block), BlockSize - BlockHeaderSize);
+    }
+    return block;
+}
+
+void ScratchBlockPool::release(ScratchBlock* const block) NOEXCEPT {
+    while (_lock.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    block->previous = _freeBlocks;
+    _freeBlocks = block;
+
+    _lock.clear(std::memory_order_release);
+}
+
+ScratchAllocator::ScratchAllocator(void* const start,
+                                   void* const end,
+                                   ScratchBlockPool& pool,
+                                   const char* const name) NOEXCEPT :
+    _pool(pool), //XXX: gcc bug prevents from using brace initialization syntax
+    _bufferStart {static_cast<uint8_t*>(start)},
+    _bufferEnd {static_cast<uint8_t*>(end)},
+    _block {nullptr},
+    _start {_bufferStart},
+    _end {_bufferEnd},
+    _current {_bufferStart},
+    _base {0},
+    _telemetry {name}
+{
+    assert(start <= end);
+    DebugFill::committed(_bufferStart, _bufferEnd - _bufferStart);
+}
+
+ScratchAllocator::~ScratchAllocator() {
+    reset();
+    DebugFill::decommitted(_bufferStart, _bufferEnd - _bufferStart);
+}
+
+size_t ScratchAllocator::usedSize() const NOEXCEPT {
+    return _base + (_current - _start);
+}
+
+void* ScratchAllocator::allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT {
+    uint8_t* const aligned =
+        util::alignUp(_current + offset, alignment) - offset;
+    if (aligned + size > _end)
+        return allocateInNewBlock(size, alignment, offset);
+
+    DebugFill::allocated(aligned, size);
+    _telemetry.allocated(aligned + size - _current);
+    _current = aligned + size;
+    return aligned;
+}
+
+void* ScratchAllocator::allocateInNewBlock(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT {
+    ScratchBlock* const block = _pool.acquire();
+    assert(("Scratch block pool is exhausted", block));
+
+    block->previous = _block;
+    block->base = usedSize();
+
+    _block = block;
+    _start = blockStart(block);
+    _end = blockEnd(block);
+    _current = _start;
+    _base = block->base;
+
+    uint8_t* const aligned =
+        util::alignUp(_current + offset, alignment) - offset;
+    assert(("Allocation does not fit into scratch block", aligned + size <= _end));
+
+    DebugFill::allocated(aligned, size);
+    _telemetry.allocated(aligned + size - _current);
+    _current = aligned + size;
+    return aligned;
+}
+
+void ScratchAllocator::releaseBlock() NOEXCEPT {
+    ScratchBlock* const block = _block;
+
+    DebugFill::freed(_start, _current - _start);
+
+    _block = block->previous;
+    _start = _block ? blockStart(_block) : _bufferStart;
+    _end = _block ? blockEnd(_block) : _bufferEnd;
+    _base = _block ? _block->base : 0;
+
+    // allocations of the previous block ended where the released block started counting
+    _current = _start + (block->base - _base);
+
+    _pool.release(block);
+}
+
+ScratchAllocator::RewindMarker ScratchAllocator::rewindMarker() const NOEXCEPT {
+    return reinterpret_cast<RewindMarker>(_current);
+}
+
+void ScratchAllocator::rewind(const RewindMarker marker) NOEXCEPT {
+    uint8_t* const rewindPoint = reinterpret_cast<uint8_t*>(marker);
+    const size_t used = usedSize();
+
+    // markers are taken and rewound in LIFO order, so blocks past the marker go back to the pool
+    while (rewindPoint < _start || rewindPoint > _current) {
+        assert(("Rewinding to a marker of another allocator", _block));
+        releaseBlock();
+    }
+
+    DebugFill::freed(rewindPoint, _current - rewindPoint);
+
+    _current = rewindPoint;
+    _telemetry.freed(used - usedSize());
+}
+
+void ScratchAllocator::reset() NOEXCEPT {
+    const size_t used = usedSize();
+
+    while (_block)
+        releaseBlock();
+
+    DebugFill::freed(_start, _current - _start);
+
+    _current = _start;
+    _telemetry.freed(used);
+}
@@ -0,0 +1,101 @@
+#ifndef ScratchAllocator_h__
+#define ScratchAllocator_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+
+#include "MemoryTelemetry.hpp"
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+struct ScratchBlock;
+
+// Fixed size blocks for scratch allocators which outgrow their buffers.
+//
+// Address space for all blocks is reserved up front, a block is committed the first
+// time it is handed out and then kept for reuse, so steady state doesn't call into the OS
+class ScratchBlockPool : public util::Noncopyable {
+public:
+    static const size_t BlockSize = 64 * 1024;
+
+private:
+    uint8_t* const _memory;
+    const size_t _maxBlockCount;
+
+    // Guards the fields below
+    std::atomic_flag _lock;
+    size_t _usedBlockCount;
+    ScratchBlock* _freeBlocks;
+
+public:
+    struct DefaultInstance {
+        static ScratchBlockPool* defaultInstance;
+
+        static const size_t DefaultMaxBlockCount = 256;
+
+        template <typename Allocator>
+        DefaultInstance(Allocator& alloc) {
+            assert(("Trying to initialize default instance twice", !defaultInstance));
+            void* const memory =
+                alloc.allocate(sizeof(ScratchBlockPool), std::alignment_of<ScratchBlockPool>::value, 0);
+            defaultInstance = new (memory) ScratchBlockPool(DefaultMaxBlockCount);
+        }
+        ~DefaultInstance();
+    };
+
+    static ScratchBlockPool& getDefault();
+
+    explicit ScratchBlockPool(const size_t maxBlockCount) NOEXCEPT;
+    ~ScratchBlockPool();
+
+    // Can be called from any thread, returns nullptr when all blocks are in use
+    ScratchBlock* acquire() NOEXCEPT;
+    void release(ScratchBlock* const block) NOEXCEPT;
+};
+
+// Linear allocator over a caller provided buffer which chains blocks from ScratchBlockPool
+// when the buffer runs out. Markers stay valid across blocks, rewinding past the start of
+// a block gives it back to the pool. Allocations must fit into a single block
+class ScratchAllocator : public util::Noncopyable {
+    ScratchBlockPool& _pool;
+
+    uint8_t* const _bufferStart;
+    uint8_t* const _bufferEnd;
+
+    // Current block, the buffer while _block is nullptr
+    ScratchBlock* _block;
+    uint8_t* _start;
+    uint8_t* _end;
+    uint8_t* _current;
+
+    // Bytes allocated before the current block started, wasted block tails are not counted
+    size_t _base;
+
+    AllocatorTelemetry _telemetry;
+
+    void* allocateInNewBlock(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT;
+    void releaseBlock() NOEXCEPT;
+
+    size_t usedSize() const NOEXCEPT;
+
+public:
+    typedef size_t RewindMarker;
+
+    ScratchAllocator(void* const start,
+                     void* const end,
+                     ScratchBlockPool& pool,
+                     const char* const name = "ScratchAllocator") NOEXCEPT;
+    ~ScratchAllocator();
+
+    void* allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT;
+
+    RewindMarker rewindMarker() const NOEXCEPT;
+    void rewind(const RewindMarker marker) NOEXCEPT;
+
+    void reset() NOEXCEPT;
+};
+
+#endif // ScratchAllocator_h__
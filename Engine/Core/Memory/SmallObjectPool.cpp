@@ -1,5 +1,8 @@
 #include "SmallObjectPool.hpp"
 
+#include <cstring>
+#include <thread>
+
 #include "Util/ptr_util.hpp"
 
 SmallObjectPool* SmallObjectPool::DefaultInstance::defaultInstance;
@@ -14,81 +17,499 @@ SmallObjectPool& SmallObjectPool::getDefault() {
     return *DefaultInstance::defaultInstance;
 }
 
+// Lives inside free chunks. Only the first chunk of a magazine uses nextMagazine
 struct FreeList {
     FreeList* next;
+    std::atomic<FreeList*> nextMagazine;
 };
 
-struct SmallObjectPoolHeader {
-    uint8_t flags : 7;
-    uint8_t allocated : 1;
-    uint8_t size;
+static_assert(sizeof(FreeList) <= SmallObjectPool::BinSize,
+              "It should be possible to store free list links inside smallest bin");
+
+#if !defined(NDEBUG) && !defined(_NDEBUG)
+static const uint8_t FreedMemoryPattern = 0xDE;
+#endif
+
+// Slab header is placed at the start of the slab, chunks follow it
+//
+// Slab is in the partial list of its bin while it has chunks to give away.
+// Chunks past carvedCount were never handed out and are not linked into the free list
+struct SmallObjectPoolSlab {
+    SmallObjectPoolSlab* next;
+    SmallObjectPoolSlab* prev;
+    FreeList* free;
+    uint16_t binIndex;
+    uint16_t chunkCount;
+    uint16_t usedCount;
+    uint16_t carvedCount;
+
+#if !defined(NDEBUG) && !defined(_NDEBUG)
+    // one bit per chunk, flipped atomically to catch objects freed twice from different threads
+    static const size_t BitmapWordCount = SmallObjectPool::SlabSize / SmallObjectPool::BinSize / 32;
+    std::atomic<uint32_t> allocated[BitmapWordCount];
+#endif
+};
+
+static const size_t SlabHeaderSize = (sizeof(SmallObjectPoolSlab) + SmallObjectPool::BinSize - 1)
+                                   & ~(SmallObjectPool::BinSize - 1);
+
+inline static size_t chunkSize(const size_t binIndex) {
+    return (binIndex + 1) * SmallObjectPool::BinSize;
+}
+
+inline static uint8_t* slabData(SmallObjectPoolSlab* const slab) {
+    return reinterpret_cast<uint8_t*>(slab) + SlabHeaderSize;
+}
+
+inline static SmallObjectPoolSlab* slabOf(void* const data) {
+    return util::alignDown(static_cast<SmallObjectPoolSlab*>(data), SmallObjectPool::SlabSize);
+}
+
+inline static size_t countChunks(const FreeList* chunk) {
+    size_t count = 0;
+    for (; chunk; chunk = chunk->next)
+        ++count;
+    return count;
+}
+
+class SpinLockGuard : public util::Noncopyable {
+    std::atomic_flag& _lock;
+
+public:
+    explicit SpinLockGuard(std::atomic_flag& lock) :
+        _lock(lock) //XXX: gcc bug prevents from using brace initialization syntax
+    {
+        while (_lock.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    ~SpinLockGuard() {
+        _lock.clear(std::memory_order_release);
+    }
 };
 
-static const size_t HeaderSize = sizeof(SmallObjectPoolHeader);
-static_assert(HeaderSize + sizeof(FreeList) <= SmallObjectPool::BinSize,
-              "It should be possible to store header and a pointer to next free chunk inside smallest bin");
+// Guards cache lists of all pools. Taken only when a thread starts or stops using a pool
+static std::atomic_flag cacheRegistryLock = ATOMIC_FLAG_INIT;
+
+#if !defined(NDEBUG) && !defined(_NDEBUG)
+// Returns previous state of the chunk
+static bool markAllocated(SmallObjectPoolSlab* const slab, void* const data, const bool allocated) {
+    const size_t index =
+        (static_cast<uint8_t*>(data) - slabData(slab)) / chunkSize(slab->binIndex);
+    const uint32_t bit = 1u << (index % 32);
+
+    std::atomic<uint32_t>& word = slab->allocated[index / 32];
+    const uint32_t previous = allocated
+        ? word.fetch_or(bit, std::memory_order_relaxed)
+        : word.fetch_and(~bit, std::memory_order_relaxed);
+
+    return (previous & bit) != 0;
+}
+#endif
 
 SmallObjectPool::~SmallObjectPool() {
+    // caches of threads which are still alive, the pool must not be used by them anymore
+    {
+        SpinLockGuard guard(cacheRegistryLock);
+        while (_caches)
+            detachCache(*_caches);
+    }
+
+    for (size_t i = 0; i < BinCount; ++i) {
+        while (FreeList* const magazine = popMagazine(i))
+            returnChunks(i, magazine);
+    }
+
+    // parent allocator gets the memory back committed, the way it handed it out
+    for (size_t i = 0; i < _decommittedSlabCount; ++i) {
+        const bool succeeded = VirtualMemory::commit(_memory + _decommittedSlabs[i] * SlabSize, SlabSize);
+        assert(("Out of memory", succeeded));
+    }
+
+    // every slab that still has chunks in use leaked them
     bool foundMemoryLeak = false;
-    uint8_t* current = _memory;
-    while (current < _current) {
-        auto header = reinterpret_cast<SmallObjectPoolHeader*>(current);
-        foundMemoryLeak |= header->allocated;
-        //TODO: trace memory leak location
-        current = current + header->size + HeaderSize;
+    for (size_t offset = 0; offset < _used; offset += SlabSize) {
+        auto slab = reinterpret_cast<const Slab*>(_memory + offset);
+        foundMemoryLeak |= slab->usedCount != 0;
     }
+
+    if (foundMemoryLeak)
+        _tracker.logLiveAllocations("Small object pool leaks");
     assert(!foundMemoryLeak);
 }
 
-inline static void setupHeader(void* data, const size_t size) {
-    auto header = reinterpret_cast<SmallObjectPoolHeader*>(data);
-    header->flags = 0;
-    header->allocated = true;
-    header->size = size;
+SmallObjectPool::ThreadCache::~ThreadCache() {
+    SpinLockGuard guard(cacheRegistryLock);
+    if (owner)
+        owner->detachCache(*this);
+}
+
+// Zero is left for caches which don't belong to any pool
+uint32_t SmallObjectPool::nextGeneration() {
+    static std::atomic<uint32_t> generation {0};
+    return generation.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+SmallObjectPool::ThreadCache& SmallObjectPool::threadCache() {
+    static thread_local ThreadCache cache;
+    return cache;
+}
+
+SmallObjectPool::ThreadCache& SmallObjectPool::currentCache() {
+    ThreadCache& cache = threadCache();
+    if (cache.owner != this || cache.generation != _generation) {
+        SpinLockGuard guard(cacheRegistryLock);
+
+        // chunks cached for another pool go back to it, otherwise they would leak there
+        if (cache.owner)
+            cache.owner->detachCache(cache);
+        attachCache(cache);
+    }
+    return cache;
+}
+
+// Both expect the cache registry lock to be held
+void SmallObjectPool::attachCache(ThreadCache& cache) {
+    cache.owner = this;
+    cache.generation = _generation;
+
+    cache.prev = nullptr;
+    cache.next = _caches;
+    if (_caches)
+        _caches->prev = &cache;
+    _caches = &cache;
+}
+
+void SmallObjectPool::detachCache(ThreadCache& cache) {
+    assert(("Thread cache outlived its pool", cache.owner == this && cache.generation == _generation));
+    flushCache(cache);
+
+    if (cache.prev)
+        cache.prev->next = cache.next;
+    else
+        _caches = cache.next;
+    if (cache.next)
+        cache.next->prev = cache.prev;
+
+    cache.owner = nullptr;
+    cache.generation = 0;
+    cache.next = nullptr;
+    cache.prev = nullptr;
+}
+
+FreeList* SmallObjectPool::chunkAt(const uint64_t head) const {
+    const uint64_t index = head & 0xFFFFFFFF;
+    return index ? reinterpret_cast<FreeList*>(_memory + (index - 1) * BinSize) : nullptr;
+}
+
+uint64_t SmallObjectPool::chunkIndex(const FreeList* const chunk) const {
+    return chunk ? (reinterpret_cast<const uint8_t*>(chunk) - _memory) / BinSize + 1 : 0;
+}
+
+FreeList* SmallObjectPool::popMagazine(const size_t binIndex) {
+    Bin& bin = _bins[binIndex];
+    uint64_t head = bin.magazines.load(std::memory_order_acquire);
+
+    for (;;) {
+        FreeList* const magazine = chunkAt(head);
+        if (!magazine)
+            return nullptr;
+
+        // magazine may be taken by another thread right now, the tag makes CAS fail in that case
+        const FreeList* const next = magazine->nextMagazine.load(std::memory_order_relaxed);
+        const uint64_t tag = (head >> 32) + 1;
+        if (bin.magazines.compare_exchange_weak(head, (tag << 32) | chunkIndex(next),
+                                                std::memory_order_acquire, std::memory_order_acquire)) {
+            bin.magazineCount.fetch_sub(1, std::memory_order_relaxed);
+            return magazine;
+        }
+    }
+}
+
+void SmallObjectPool::pushMagazine(const size_t binIndex, FreeList* const magazine) {
+    Bin& bin = _bins[binIndex];
+    bin.magazineCount.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t head = bin.magazines.load(std::memory_order_relaxed);
+    for (;;) {
+        magazine->nextMagazine.store(chunkAt(head), std::memory_order_relaxed);
+        const uint64_t tag = (head >> 32) + 1;
+        if (bin.magazines.compare_exchange_weak(head, (tag << 32) | chunkIndex(magazine),
+                                                std::memory_order_release, std::memory_order_relaxed))
+            return;
+    }
+}
+
+SmallObjectPoolSlab* SmallObjectPool::acquireSlab(const size_t binIndex) {
+    Slab* slab;
+    bool decommitted = false;
+    {
+        SpinLockGuard guard(_slabLock);
+
+        slab = _freeSlabs;
+        if (slab) {
+            _freeSlabs = slab->next;
+            --_freeSlabCount;
+        } else if (_decommittedSlabCount) {
+            slab = reinterpret_cast<Slab*>(_memory + _decommittedSlabs[--_decommittedSlabCount] * SlabSize);
+            decommitted = true;
+        } else {
+            assert(("Not enough memory", _size - _used >= SlabSize));
+            slab = reinterpret_cast<Slab*>(_memory + _used);
+            _used += SlabSize;
+        }
+    }
+    _slabCount.fetch_add(1, std::memory_order_relaxed);
+
+    // nobody else can reach the slab, it is committed outside the lock
+    if (decommitted) {
+        const bool succeeded = VirtualMemory::commit(slab, SlabSize);
+        assert(("Out of memory", succeeded));
+    }
+
+    new (slab) Slab();
+    slab->binIndex = static_cast<uint16_t>(binIndex);
+    slab->chunkCount = static_cast<uint16_t>((SlabSize - SlabHeaderSize) / chunkSize(binIndex));
+    return slab;
+}
+
+void SmallObjectPool::releaseSlab(Slab* const slab) {
+    _slabCount.fetch_sub(1, std::memory_order_relaxed);
+    {
+        SpinLockGuard guard(_slabLock);
+
+        if (!_decommitsSlabs || _freeSlabCount < MaxCommittedFreeSlabCount) {
+            slab->next = _freeSlabs;
+            _freeSlabs = slab;
+            ++_freeSlabCount;
+            return;
+        }
+    }
+
+    decommitSlab(slab);
+}
+
+// Slab must not be reachable by other threads, it is listed only after its memory is gone
+void SmallObjectPool::decommitSlab(Slab* const slab) {
+    const size_t index = (reinterpret_cast<uint8_t*>(slab) - _memory) / SlabSize;
+    VirtualMemory::decommit(slab, SlabSize);
+
+    SpinLockGuard guard(_slabLock);
+    _decommittedSlabs[_decommittedSlabCount++] = static_cast<uint32_t>(index);
+}
+
+// Takes chunks from partial slabs of the bin, new slabs are added when they run out
+FreeList* SmallObjectPool::takeChunks(const size_t binIndex, const size_t count) {
+    Bin& bin = _bins[binIndex];
+    const size_t size = chunkSize(binIndex);
+
+    SpinLockGuard guard(bin.lock);
+
+    FreeList* chunks = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        Slab* slab = bin.partial;
+        if (!slab) {
+            slab = acquireSlab(binIndex);
+            bin.partial = slab;
+        }
+
+        FreeList* chunk = slab->free;
+        if (chunk) {
+            slab->free = chunk->next;
+        } else {
+            chunk = reinterpret_cast<FreeList*>(slabData(slab) + slab->carvedCount * size);
+            ++slab->carvedCount;
+
+#if !defined(NDEBUG) && !defined(_NDEBUG)
+            memset(static_cast<void*>(chunk), FreedMemoryPattern, size);
+#endif
+        }
+
+        // full slabs leave the partial list until one of their chunks comes back
+        if (++slab->usedCount == slab->chunkCount) {
+            bin.partial = slab->next;
+            if (bin.partial)
+                bin.partial->prev = nullptr;
+
+            slab->next = nullptr;
+        }
+
+        chunk->next = chunks;
+        chunks = chunk;
+    }
+
+    return chunks;
+}
+
+// Puts chunks back to their slabs, slabs which become empty are released
+void SmallObjectPool::returnChunks(const size_t binIndex, FreeList* chunks) {
+    Bin& bin = _bins[binIndex];
+
+    SpinLockGuard guard(bin.lock);
+
+    while (chunks) {
+        FreeList* const chunk = chunks;
+        chunks = chunk->next;
+
+        Slab* const slab = slabOf(chunk);
+        assert(("Chunk belongs to another bin", slab->binIndex == binIndex));
+
+        if (slab->usedCount == slab->chunkCount) {
+            slab->prev = nullptr;
+            slab->next = bin.partial;
+            if (bin.partial)
+                bin.partial->prev = slab;
+            bin.partial = slab;
+        }
+
+        chunk->next = slab->free;
+        slab->free = chunk;
+
+        if (--slab->usedCount)
+            continue;
+
+        if (slab->prev)
+            slab->prev->next = slab->next;
+        else
+            bin.partial = slab->next;
+
+        if (slab->next)
+            slab->next->prev = slab->prev;
+
+        releaseSlab(slab);
+    }
 }
 
 void* SmallObjectPool::allocate(const size_t size, const size_t alignment, const size_t offset) {
-    assert(("Not enough memory", _size - (_current - _memory) >= size + HeaderSize));
     assert(("Trying to use small object pool for big objects", size <= MaxSmallObjectSize));
-    assert(("Unsupported alignment", alignment == BinSize || alignment == 1));
+    assert(("Unsupported alignment", alignment <= BinSize && (alignment & (alignment - 1)) == 0));
     assert(("Offset must be a multiple of alignment", (offset & (alignment - 1)) == 0));
 
-    const size_t binIndex = size >> BinSizeBitShift;
-    FreeList* bin = _free[binIndex];
-    if (bin) {
-        _free[binIndex] = bin->next;
-        auto header = reinterpret_cast<SmallObjectPoolHeader*>(bin) - 1;
-        header->allocated = true;
+    const size_t binIndex = size ? (size - 1) >> BinSizeBitShift : 0;
+    ThreadCache& cache = currentCache();
+
+    FreeList* chunk = cache.chunks[binIndex];
+    if (!chunk) {
+        chunk = popMagazine(binIndex);
+        if (!chunk)
+            chunk = takeChunks(binIndex, MagazineSize);
 
-        return bin;
+        cache.counts[binIndex] = countChunks(chunk);
     }
 
-    uint8_t* aligned =
-        util::alignUp(_current + offset + HeaderSize, alignment) - offset - HeaderSize;
-    setupHeader(aligned, size);
+    cache.chunks[binIndex] = chunk->next;
+    --cache.counts[binIndex];
 
-    _current = aligned + size + HeaderSize;
-    return aligned + HeaderSize;
+    _telemetry.allocated(chunkSize(binIndex));
+    _tracker.allocated(chunk, size);
+
+#if !defined(NDEBUG) && !defined(_NDEBUG)
+    Slab* const slab = slabOf(chunk);
+    assert(("Chunk is allocated twice", !markAllocated(slab, chunk, true)));
+
+    // someone wrote to the chunk after freeing it, possibly from another thread
+    const uint8_t* const data = reinterpret_cast<const uint8_t*>(chunk);
+    const uint8_t* const end = data + chunkSize(binIndex);
+    const bool modified =
+        std::find_if(data + sizeof(FreeList), end, [](const uint8_t value) {
+            return value != FreedMemoryPattern;
+        }) != end;
+    assert(("Freed memory was modified", !modified));
+#endif
+
+    return chunk;
 }
 
 void SmallObjectPool::free(void* data) {
-    assert(("Freeing memory not associated to pool", _memory <= data && data <= _current));
-    auto header = reinterpret_cast<SmallObjectPoolHeader*>(data) - 1;
-    assert(("Freeing unallocated memory", header->allocated));
-    assert(("Freeing invalid memory", header->size <= MaxSmallObjectSize));
+    assert(("Freeing memory not associated to pool", _memory <= data && data < _memory + _size));
+
+    Slab* const slab = slabOf(data);
+    const size_t binIndex = slab->binIndex;
+    assert(("Freeing invalid memory", binIndex < BinCount));
 
 #if !defined(NDEBUG) && !defined(_NDEBUG)
-    memset(data, 0xDE, header->size);
+    assert(("Freeing unallocated memory", markAllocated(slab, data, false)));
+    memset(data, FreedMemoryPattern, chunkSize(binIndex));
 #endif
 
-    header->allocated = false;
+    _telemetry.freed(chunkSize(binIndex));
+    _tracker.freed(data);
+
+    ThreadCache& cache = currentCache();
+
+    auto chunk = static_cast<FreeList*>(data);
+    chunk->next = cache.chunks[binIndex];
+    cache.chunks[binIndex] = chunk;
+
+    if (++cache.counts[binIndex] < MaxCachedChunkCount)
+        return;
+
+    // hand a magazine over to other threads or back to the slabs
+    FreeList* const magazine = chunk;
+    for (size_t i = 1; i < MagazineSize; ++i)
+        chunk = chunk->next;
+
+    cache.chunks[binIndex] = chunk->next;
+    cache.counts[binIndex] -= MagazineSize;
+    chunk->next = nullptr;
+
+    if (_bins[binIndex].magazineCount.load(std::memory_order_relaxed) < MaxMagazineCount)
+        pushMagazine(binIndex, magazine);
+    else
+        returnChunks(binIndex, magazine);
+}
+
+void SmallObjectPool::flushCache(ThreadCache& cache) {
+    for (size_t i = 0; i < BinCount; ++i) {
+        if (cache.chunks[i])
+            returnChunks(i, cache.chunks[i]);
 
-    const size_t binIndex = header->size >> BinSizeBitShift;
-    FreeList* bin = _free[binIndex];
-    if (bin) {
-        bin->next = reinterpret_cast<FreeList*>(data);
-    } else {
-        _free[binIndex] = reinterpret_cast<FreeList*>(data);
-        _free[binIndex]->next = nullptr;
+        cache.chunks[i] = nullptr;
+        cache.counts[i] = 0;
     }
 }
+
+size_t SmallObjectPool::usedSize() const {
+    return _slabCount.load(std::memory_order_relaxed) * SlabSize;
+}
+
+size_t SmallObjectPool::committedSize() const {
+    SpinLockGuard guard(_slabLock);
+    return _used - _decommittedSlabCount * SlabSize;
+}
+
+void SmallObjectPool::trim() {
+    for (size_t i = 0; i < BinCount; ++i) {
+        while (FreeList* const magazine = popMagazine(i))
+            returnChunks(i, magazine);
+    }
+
+    if (!_decommitsSlabs)
+        return;
+
+    for (;;) {
+        Slab* slab;
+        {
+            SpinLockGuard guard(_slabLock);
+
+            slab = _freeSlabs;
+            if (!slab)
+                return;
+
+            _freeSlabs = slab->next;
+            --_freeSlabCount;
+        }
+
+        decommitSlab(slab);
+    }
+}
+
+void SmallObjectPool::releaseThreadCache() {
+    ThreadCache& cache = threadCache();
+    if (!cache.owner)
+        return;
+
+    SpinLockGuard guard(cacheRegistryLock);
+    if (cache.owner)
+        cache.owner->detachCache(cache);
+}
@@ -1,34 +1,142 @@
 #ifndef SmallObjectPool_h__
 #define SmallObjectPool_h__
 
-#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <type_traits>
 
+#include "AllocationTracker.hpp"
+#include "MemoryTelemetry.hpp"
+#include "VirtualMemory.hpp"
 #include "Util/noncopyable.hpp"
 
 struct FreeList;
+struct SmallObjectPoolSlab;
 
+// Pool of small objects which can be used from any thread.
+//
+// Pool memory is split into SlabSize aligned slabs, every slab holds chunks of a single bin
+// and keeps its own free list, so objects don't need a header. Slabs which become empty
+// go back to the pool and can be reused by any bin. A few of them stay committed,
+// the rest are decommitted and give their memory back to the OS until they are reused,
+// so pool memory has to come from an allocator backed by virtual memory like the app heap.
+//
+// Every thread keeps a cache of free chunks per bin and only talks to the shared
+// part of the pool when its cache runs empty or grows too big. Chunks move between
+// threads in magazines of MagazineSize chunks through a lock-free stack per bin,
+// only when there are too many magazines or none at all the bin is locked to return
+// chunks to their slabs or to take new ones.
+//
+// Objects may be freed by a thread other than the one that allocated them.
+// Cached chunks go back to the pool when their thread exits or the pool is destroyed,
+// threads that stop using the pool earlier can give them back with releaseThreadCache
 class SmallObjectPool : public util::Noncopyable {
-    FreeList** _free;
-    uint8_t* _memory;
-    uint8_t* _current;
-    size_t _size;
-
-    static const size_t MaxSmallObjectSize = 128;
-    static_assert(MaxSmallObjectSize <= 0xFF, "MaxSmallObjectSize is too big");
-
 public:
     static const size_t BinSize = 16;
     static_assert((BinSize & (BinSize - 1)) == 0, "BinSize must be power of two");
 
+    static const size_t SlabSize = 4096;
+    static_assert((SlabSize & (SlabSize - 1)) == 0, "SlabSize must be power of two");
+
 private:
+    static const size_t MaxSmallObjectSize = 128;
+
     static const size_t BinSizeBitShift = 4;
     static_assert(BinSize == (1 << BinSizeBitShift), "BinSize and BinSizeBitShift are out of sync");
 
     static const size_t BinCount = MaxSmallObjectSize / BinSize;
-    static const size_t FreeListStorageSize = BinCount * sizeof(FreeList*);
+
+    static const size_t MagazineSize = 16;
+
+    // Threads return a magazine to the shared stack once they cache that many chunks of a bin
+    static const size_t MaxCachedChunkCount = 2 * MagazineSize;
+
+    // Magazines over that limit are returned to their slabs so that empty slabs can be reused
+    static const size_t MaxMagazineCount = 8;
+
+    // Empty slabs over that count are decommitted
+    static const size_t MaxCommittedFreeSlabCount = 8;
+
+    typedef SmallObjectPoolSlab Slab;
+
+    struct Bin {
+        // Head of magazine stack, chunk index in the low half and ABA tag in the high half
+        std::atomic<uint64_t> magazines;
+        std::atomic<size_t> magazineCount;
+
+        // Guards slab lists of the bin
+        std::atomic_flag lock;
+        Slab* partial;
+    };
+
+    struct ThreadCache {
+        SmallObjectPool* owner;
+        uint32_t generation;
+
+        // Links caches of the owner pool, guarded by the cache registry lock
+        ThreadCache* next;
+        ThreadCache* prev;
+
+        FreeList* chunks[BinCount];
+        size_t counts[BinCount];
+
+        // Gives cached chunks back to the owner when the thread exits
+        ~ThreadCache();
+    };
+
+    uint8_t* const _memory;
+    const size_t _size;
+
+    // Tells apart pools placed at the same address one after another
+    const uint32_t _generation;
+
+    // Caches of threads using the pool, drained when it is destroyed
+    ThreadCache* _caches;
+
+    // Guards slabs which are not owned by any bin
+    mutable std::atomic_flag _slabLock;
+    size_t _used;
+    Slab* _freeSlabs;
+    size_t _freeSlabCount;
+
+    // Indices of empty slabs whose memory went back to the OS
+    uint32_t* const _decommittedSlabs;
+    size_t _decommittedSlabCount;
+
+    // Slabs can't be decommitted alone when they are smaller than a page
+    const bool _decommitsSlabs;
+
+    // Slabs handed to bins, read without the lock by usedSize
+    std::atomic<size_t> _slabCount;
+
+    Bin _bins[BinCount];
+
+    AllocatorTelemetry _telemetry;
+    AllocationTracker _tracker;
+
+    static uint32_t nextGeneration();
+
+    static ThreadCache& threadCache();
+
+    ThreadCache& currentCache();
+    void attachCache(ThreadCache& cache);
+    void detachCache(ThreadCache& cache);
+
+    FreeList* chunkAt(const uint64_t head) const;
+    uint64_t chunkIndex(const FreeList* const chunk) const;
+
+    FreeList* popMagazine(const size_t binIndex);
+    void pushMagazine(const size_t binIndex, FreeList* const magazine);
+
+    Slab* acquireSlab(const size_t binIndex);
+    void releaseSlab(Slab* const slab);
+    void decommitSlab(Slab* const slab);
+
+    FreeList* takeChunks(const size_t binIndex, const size_t count);
+    void returnChunks(const size_t binIndex, FreeList* chunks);
+
+    void flushCache(ThreadCache& cache);
 
 public:
     struct DefaultInstance {
@@ -49,18 +157,53 @@ public:
     static SmallObjectPool& getDefault();
 
     template <typename Allocator>
-    SmallObjectPool(Allocator& alloc, const size_t size) :
-        _free {static_cast<FreeList**>(alloc.allocate(size + FreeListStorageSize, 1, FreeListStorageSize))},
-        _memory {reinterpret_cast<uint8_t*>(_free) + FreeListStorageSize},
-        _current {_memory},
-        _size {size}
+    SmallObjectPool(Allocator& alloc, const size_t size, const char* const name = "SmallObjectPool") :
+        _memory {static_cast<uint8_t*>(alloc.allocate(size, SlabSize, 0))},
+        _size {size},
+        _generation {nextGeneration()},
+        _caches {nullptr},
+        _used {0},
+        _freeSlabs {nullptr},
+        _freeSlabCount {0},
+        _decommittedSlabs {static_cast<uint32_t*>(
+            alloc.allocate(size / SlabSize * sizeof(uint32_t), std::alignment_of<uint32_t>::value, 0))},
+        _decommittedSlabCount {0},
+        _decommitsSlabs {SlabSize % VirtualMemory::pageSize() == 0},
+        _slabCount {0},
+        _telemetry {name},
+        _tracker {alloc, _memory, size, BinSize}
     {
-        std::fill_n(_free, BinCount, nullptr);
+        _slabLock.clear();
+
+        for (size_t i = 0; i < BinCount; ++i) {
+            _bins[i].magazines.store(0, std::memory_order_relaxed);
+            _bins[i].magazineCount.store(0, std::memory_order_relaxed);
+            _bins[i].lock.clear();
+            _bins[i].partial = nullptr;
+        }
     }
     ~SmallObjectPool();
 
     void* allocate(const size_t size, const size_t alignment, const size_t offset);
     void free(void* data);
+
+    // Bytes of slabs handed to bins, free chunks inside them included
+    size_t usedSize() const;
+
+    // Bytes of pool memory which are still committed
+    size_t committedSize() const;
+
+    // Returns magazines parked in the bins to their slabs and decommits every empty slab.
+    // Chunks cached by threads stay there, they have to call releaseThreadCache first
+    void trim();
+
+    // Logs live objects grouped by call stack, empty unless ENABLE_ALLOCATION_TRACKING is defined
+    void logLiveAllocations(const char* const title) const {
+        _tracker.logLiveAllocations(title);
+    }
+
+    // Returns chunks cached by the calling thread to the pool it got them from
+    static void releaseThreadCache();
 };
 
 #endif // SmallObjectPool_h__
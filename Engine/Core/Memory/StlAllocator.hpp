@@ -0,0 +1,75 @@
+#ifndef StlAllocator_h__
+#define StlAllocator_h__
+
+#include <cstdlib>
+#include <type_traits>
+
+#include "Util/defines.hpp"
+#include "Util/type_traits.hpp"
+
+// Lets std containers take memory from engine allocators, for example
+//
+//     std::vector<int, StlAllocator<int, TlsfAllocator>> v {StlAllocator<int, TlsfAllocator>(heap)};
+//
+// Works with anything that has allocate(size, alignment, offset). Memory is given back
+// with free(pointer) when the allocator has it, arenas like LinearAllocator and ScopeStack
+// keep it until they are rewound. Container must not outlive the allocator.
+//
+// Allocator has to serve the biggest block the container asks for. SmallObjectPool only
+// takes objects up to 128 bytes, so it suits node containers like std::list or std::map
+// but not growing ones like std::vector
+template <typename T, typename Allocator>
+class StlAllocator {
+    template <typename U, typename OtherAllocator>
+    friend class StlAllocator;
+
+    Allocator* _alloc;
+
+    static void release(Allocator& alloc, T* const data, std::true_type) NOEXCEPT {
+        alloc.free(data);
+    }
+
+    static void release(Allocator&, T* const, std::false_type) NOEXCEPT {
+    }
+
+public:
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind {
+        typedef StlAllocator<U, Allocator> other;
+    };
+
+    explicit StlAllocator(Allocator& alloc) NOEXCEPT :
+        _alloc {&alloc}
+    {}
+
+    template <typename U>
+    StlAllocator(const StlAllocator<U, Allocator>& other) NOEXCEPT :
+        _alloc {other._alloc}
+    {}
+
+    T* allocate(const size_t count) {
+        return static_cast<T*>(_alloc->allocate(sizeof(T) * count, std::alignment_of<T>::value, 0));
+    }
+
+    void deallocate(T* const data, const size_t) NOEXCEPT {
+        release(*_alloc, data, std::integral_constant<bool, util::HasFree<Allocator>::value>());
+    }
+
+    Allocator& allocator() const NOEXCEPT {
+        return *_alloc;
+    }
+
+    template <typename U>
+    bool operator ==(const StlAllocator<U, Allocator>& other) const NOEXCEPT {
+        return _alloc == other._alloc;
+    }
+
+    template <typename U>
+    bool operator !=(const StlAllocator<U, Allocator>& other) const NOEXCEPT {
+        return _alloc != other._alloc;
+    }
+};
+
+#endif // StlAllocator_h__
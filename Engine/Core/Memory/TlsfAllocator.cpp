@@ -0,0 +1,372 @@
+#include "TlsfAllocator.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include "DebugFill.hpp"
+#include "Util/ptr_util.hpp"
+
+#if !defined(__GNUC__) && !defined(__clang__)
+#  include <intrin.h>
+#endif
+
+TlsfAllocator* TlsfAllocator::DefaultInstance::defaultInstance;
+
+TlsfAllocator::DefaultInstance::~DefaultInstance() {
+    assert(("Default instance already destroyed", defaultInstance));
+    defaultInstance->~TlsfAllocator();
+    defaultInstance = nullptr;
+}
+
+TlsfAllocator& TlsfAllocator::getDefault() {
+    return *DefaultInstance::defaultInstance;
+}
+
+// Header of every block, links to other free blocks are stored in the data of free blocks
+struct TlsfBlock {
+    TlsfBlock* previousPhysical;
+
+    // Whole block size including the header, the lowest bit is set for free blocks
+    size_t size;
+
+    TlsfBlock* nextFree;
+    TlsfBlock* previousFree;
+};
+
+static const size_t FreeBit = 1;
+
+static const size_t HeaderSize = (2 * sizeof(void*) + TlsfAllocator::Granularity - 1)
+                               & ~(TlsfAllocator::Granularity - 1);
+
+// Free block has to fit free list links
+static const size_t MinBlockSize = (sizeof(TlsfBlock) + TlsfAllocator::Granularity - 1)
+                                 & ~(TlsfAllocator::Granularity - 1);
+
+// Free list links are stored right after the header, they are never poisoned
+static const size_t LinkSize = MinBlockSize - HeaderSize;
+
+inline static size_t floorLog2(const size_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(static_cast<unsigned long long>(value));
+#elif defined(_WIN64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#else
+    unsigned long index;
+    _BitScanReverse(&index, value);
+    return index;
+#endif
+}
+
+inline static size_t lowestBit(const uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(value);
+#else
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return index;
+#endif
+}
+
+inline static size_t blockSize(const TlsfBlock* const block) {
+    return block->size & ~FreeBit;
+}
+
+inline static bool isFree(const TlsfBlock* const block) {
+    return (block->size & FreeBit) != 0;
+}
+
+inline static TlsfBlock* nextPhysical(TlsfBlock* const block) {
+    return reinterpret_cast<TlsfBlock*>(reinterpret_cast<uint8_t*>(block) + blockSize(block));
+}
+
+inline static uint8_t* blockData(TlsfBlock* const block) {
+    return reinterpret_cast<uint8_t*>(block) + HeaderSize;
+}
+
+// Cuts the block in two, the second part is returned and keeps the free bit of the block
+static TlsfBlock* splitBlock(TlsfBlock* const block, const size_t size) {
+    auto rest = reinterpret_cast<TlsfBlock*>(reinterpret_cast<uint8_t*>(block) + size);
+
+    // header and links of the second part land in the poisoned data of a free block
+    DebugFill::allocated(rest, MinBlockSize);
+    rest->previousPhysical = block;
+    rest->size = block->size - size;
+    nextPhysical(rest)->previousPhysical = rest;
+
+    block->size = size | (block->size & FreeBit);
+    return rest;
+}
+
+TlsfAllocator::TlsfAllocator(void* const start, void* const end, const char* const name) NOEXCEPT :
+    _memory {static_cast<uint8_t*>(start)},
+    _size {static_cast<size_t>(static_cast<uint8_t*>(end) - static_cast<uint8_t*>(start)) & ~(Granularity - 1)},
+    _committed {_size},
+    _commitGranularity {0},
+    _used {0},
+    _telemetry {name}
+{
+    init();
+}
+
+TlsfAllocator::TlsfAllocator(const size_t reserveSize,
+                             const VirtualMemory::PageKind kind,
+                             const char* const name) NOEXCEPT :
+    _memory {nullptr},
+    _size {0},
+    _committed {0},
+    _commitGranularity {VirtualMemory::commitGranularity(kind)},
+    _used {0},
+    _telemetry {name}
+{
+    _size = util::alignUp(reserveSize, _commitGranularity);
+
+    _memory = static_cast<uint8_t*>(VirtualMemory::reserve(_size, kind));
+    assert(("Could not reserve address space", _memory));
+
+    // region starts with a single granule
+    const bool succeeded = VirtualMemory::commit(_memory, _commitGranularity);
+    assert(("Out of memory", succeeded));
+    _committed.store(_commitGranularity, std::memory_order_relaxed);
+
+    init();
+}
+
+TlsfAllocator::~TlsfAllocator() {
+    assert(("Memory leak detected", _used.load(std::memory_order_relaxed) == 0));
+
+    DebugFill::decommitted(_memory, _committed.load(std::memory_order_relaxed));
+    if (_commitGranularity)
+        VirtualMemory::release(_memory, _size);
+}
+
+void TlsfAllocator::init() NOEXCEPT {
+    const size_t committed = _committed.load(std::memory_order_relaxed);
+
+    assert(("Memory must be aligned", util::alignUp(_memory, Granularity) == _memory));
+    assert(("Region is too small", committed >= MinBlockSize + HeaderSize));
+    assert(("Region is too big", _size - HeaderSize < MaxSize));
+
+    _lock.clear();
+
+    _firstLevelMap = 0;
+    std::fill_n(_secondLevelMaps, FirstLevelCount, 0);
+    std::fill_n(&_freeLists[0][0], FirstLevelCount * SecondLevelCount, nullptr);
+
+    // whole region is one free block followed by an empty used block, so every block has a next one
+    auto block = reinterpret_cast<TlsfBlock*>(_memory);
+    block->previousPhysical = nullptr;
+    block->size = (committed - HeaderSize) | FreeBit;
+
+    TlsfBlock* const sentinel = nextPhysical(block);
+    sentinel->previousPhysical = block;
+    sentinel->size = 0;
+
+    DebugFill::committed(blockData(block) + LinkSize, blockSize(block) - MinBlockSize);
+    insertFreeBlock(block);
+}
+
+// Size class of the block, sizes within a class differ by less than 1/SecondLevelCount
+void TlsfAllocator::mapping(const size_t size, size_t& firstLevel, size_t& secondLevel) NOEXCEPT {
+    if (size < SmallBlockSize) {
+        firstLevel = 0;
+        secondLevel = size >> GranularityLog2;
+    } else {
+        const size_t log2 = floorLog2(size);
+        firstLevel = log2 - (SecondLevelCountLog2 + GranularityLog2 - 1);
+        secondLevel = (size >> (log2 - SecondLevelCountLog2)) - SecondLevelCount;
+    }
+}
+
+void TlsfAllocator::insertFreeBlock(TlsfBlock* const block) NOEXCEPT {
+    size_t firstLevel, secondLevel;
+    mapping(blockSize(block), firstLevel, secondLevel);
+
+    TlsfBlock*& head = _freeLists[firstLevel][secondLevel];
+    block->size |= FreeBit;
+    block->previousFree = nullptr;
+    block->nextFree = head;
+    if (head)
+        head->previousFree = block;
+    head = block;
+
+    _firstLevelMap |= 1u << firstLevel;
+    _secondLevelMaps[firstLevel] |= 1u << secondLevel;
+}
+
+void TlsfAllocator::removeFreeBlock(TlsfBlock* const block) NOEXCEPT {
+    size_t firstLevel, secondLevel;
+    mapping(blockSize(block), firstLevel, secondLevel);
+
+    if (block->nextFree)
+        block->nextFree->previousFree = block->previousFree;
+
+    if (block->previousFree) {
+        block->previousFree->nextFree = block->nextFree;
+    } else {
+        _freeLists[firstLevel][secondLevel] = block->nextFree;
+        if (!block->nextFree) {
+            _secondLevelMaps[firstLevel] &= ~(1u << secondLevel);
+            if (!_secondLevelMaps[firstLevel])
+                _firstLevelMap &= ~(1u << firstLevel);
+        }
+    }
+
+    block->size &= ~FreeBit;
+}
+
+// Any block of the class of the rounded size is big enough
+size_t TlsfAllocator::roundUpToClass(const size_t size) NOEXCEPT {
+    return size < SmallBlockSize
+        ? size
+        : size + (static_cast<size_t>(1) << (floorLog2(size) - SecondLevelCountLog2)) - 1;
+}
+
+TlsfBlock* TlsfAllocator::findFreeBlock(const size_t size) NOEXCEPT {
+    size_t firstLevel, secondLevel;
+    mapping(roundUpToClass(size), firstLevel, secondLevel);
+    if (firstLevel >= FirstLevelCount)
+        return nullptr;
+
+    uint32_t secondLevelMap = _secondLevelMaps[firstLevel] & (~0u << secondLevel);
+    if (!secondLevelMap) {
+        const uint32_t firstLevelMap = _firstLevelMap & (~0u << (firstLevel + 1));
+        if (!firstLevelMap)
+            return nullptr;
+
+        firstLevel = lowestBit(firstLevelMap);
+        secondLevelMap = _secondLevelMaps[firstLevel];
+    }
+
+    return _freeLists[firstLevel][lowestBit(secondLevelMap)];
+}
+
+// Commits enough memory past the sentinel for a block of the given size. The sentinel header
+// becomes the header of the new free block, which is merged with the last block if that one is free
+bool TlsfAllocator::grow(const size_t size) NOEXCEPT {
+    if (!_commitGranularity)
+        return false;
+
+    const size_t committed = _committed.load(std::memory_order_relaxed);
+    const size_t needed = roundUpToClass(size);
+    const size_t step = std::min(util::alignUp(needed, _commitGranularity), _size - committed);
+    if (step < needed || !VirtualMemory::commit(_memory + committed, step))
+        return false;
+
+    _committed.store(committed + step, std::memory_order_relaxed);
+
+    // old sentinel header is the header of the new block, new sentinel header takes the end
+    DebugFill::committed(_memory + committed + LinkSize, step - LinkSize - HeaderSize);
+
+    TlsfBlock* block = reinterpret_cast<TlsfBlock*>(_memory + committed - HeaderSize);
+    block->size = step;
+
+    TlsfBlock* const sentinel = nextPhysical(block);
+    sentinel->size = 0;
+
+    TlsfBlock* const previous = block->previousPhysical;
+    if (isFree(previous)) {
+        removeFreeBlock(previous);
+        previous->size += step;
+        block = previous;
+    }
+
+    sentinel->previousPhysical = block;
+    insertFreeBlock(block);
+    return true;
+}
+
+void* TlsfAllocator::allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT {
+    assert(("Alignment must be power of two", alignment && (alignment & (alignment - 1)) == 0));
+    assert(("Offset must be a multiple of alignment", (offset & (alignment - 1)) == 0));
+
+    const size_t needed = std::max(util::alignUp(size + HeaderSize, Granularity), MinBlockSize);
+
+    // leading gap, if there is one, has to be big enough to become a free block
+    const size_t searchSize = alignment > Granularity
+        ? needed + alignment + MinBlockSize
+        : needed;
+
+    while (_lock.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    TlsfBlock* block = findFreeBlock(searchSize);
+    if (!block && grow(searchSize))
+        block = findFreeBlock(searchSize);
+
+    if (!block) {
+        _lock.clear(std::memory_order_release);
+        return nullptr;
+    }
+    removeFreeBlock(block);
+
+    if (alignment > Granularity) {
+        uint8_t* const data = blockData(block);
+        size_t gap = util::alignUp(data + offset, alignment) - offset - data;
+        if (gap && gap < MinBlockSize)
+            gap += alignment;
+
+        if (gap) {
+            TlsfBlock* const leading = block;
+            block = splitBlock(leading, gap);
+            insertFreeBlock(leading);
+        }
+    }
+
+    if (blockSize(block) - needed >= MinBlockSize)
+        insertFreeBlock(splitBlock(block, needed));
+
+    const size_t allocated = blockSize(block);
+    _lock.clear(std::memory_order_release);
+
+    _used.fetch_add(allocated, std::memory_order_relaxed);
+    _telemetry.allocated(allocated);
+
+    uint8_t* const data = blockData(block);
+    DebugFill::allocated(data, size);
+    return data;
+}
+
+void TlsfAllocator::free(void* const data) NOEXCEPT {
+    assert(("Freeing memory not associated to allocator", _memory < data && data < _memory + _size));
+
+    auto block = reinterpret_cast<TlsfBlock*>(static_cast<uint8_t*>(data) - HeaderSize);
+    assert(("Freeing unallocated memory", !isFree(block)));
+
+    const size_t freed = blockSize(block);
+
+    DebugFill::freed(static_cast<uint8_t*>(data) + LinkSize, freed - MinBlockSize);
+
+    while (_lock.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    TlsfBlock* const previous = block->previousPhysical;
+    if (previous && isFree(previous)) {
+        removeFreeBlock(previous);
+        previous->size += blockSize(block);
+        block = previous;
+    }
+
+    TlsfBlock* const next = nextPhysical(block);
+    if (isFree(next)) {
+        removeFreeBlock(next);
+        block->size += blockSize(next);
+    }
+
+    nextPhysical(block)->previousPhysical = block;
+    insertFreeBlock(block);
+
+    _lock.clear(std::memory_order_release);
+
+    _used.fetch_sub(freed, std::memory_order_relaxed);
+    _telemetry.freed(freed);
+}
+
+size_t TlsfAllocator::usedSize() const NOEXCEPT {
+    return _used.load(std::memory_order_relaxed);
+}
+
+size_t TlsfAllocator::committedSize() const NOEXCEPT {
+    return _committed.load(std::memory_order_relaxed);
+}
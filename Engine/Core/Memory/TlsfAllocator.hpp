@@ -0,0 +1,134 @@
+#ifndef TlsfAllocator_h__
+#define TlsfAllocator_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#include "MemoryTelemetry.hpp"
+#include "VirtualMemory.hpp"
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+struct TlsfBlock;
+
+// Two-level segregated fit allocator for memory freed in any order.
+//
+// Free blocks are kept in lists by size class, the first level splits sizes by powers
+// of two and the second level splits every power of two range into SecondLevelCount
+// classes. Bitmaps of non-empty lists make both allocation and freeing O(1).
+// Every block has a header with its size and a link to the physically previous block,
+// freed blocks are merged with free neighbours right away.
+//
+// Allocator which reserves its own address space commits it as it runs out of free blocks,
+// the committed part is added to the end of the region as one more free block.
+//
+// Allocation and freeing can be done from any thread
+class TlsfAllocator : public util::Noncopyable {
+public:
+    // Block sizes and returned addresses are multiples of this
+    static const size_t Granularity = 16;
+
+private:
+    static const size_t GranularityLog2 = 4;
+    static_assert(Granularity == (1 << GranularityLog2), "Granularity and GranularityLog2 are out of sync");
+
+    static const size_t SecondLevelCountLog2 = 4;
+    static const size_t SecondLevelCount = 1 << SecondLevelCountLog2;
+
+    // Blocks smaller than that are split into second level classes linearly
+    static const size_t SmallBlockSize = 1 << (SecondLevelCountLog2 + GranularityLog2);
+
+    // Enough for regions up to 4GB on 64-bit and 2GB on 32-bit platforms
+    static const size_t FirstLevelCount = sizeof(size_t) >= 8 ? 25 : 24;
+
+    uint8_t* _memory;
+    size_t _size;
+
+    // Bytes at the start of the region backed by memory, written under the lock
+    std::atomic<size_t> _committed;
+
+    // Zero when allocator works over memory it doesn't own
+    const size_t _commitGranularity;
+
+    std::atomic<size_t> _used;
+
+    // Guards free lists and bitmaps
+    std::atomic_flag _lock;
+
+    uint32_t _firstLevelMap;
+    uint32_t _secondLevelMaps[FirstLevelCount];
+    TlsfBlock* _freeLists[FirstLevelCount][SecondLevelCount];
+
+    AllocatorTelemetry _telemetry;
+
+    static void mapping(const size_t size, size_t& firstLevel, size_t& secondLevel) NOEXCEPT;
+    static size_t roundUpToClass(const size_t size) NOEXCEPT;
+
+    void init() NOEXCEPT;
+
+    void insertFreeBlock(TlsfBlock* const block) NOEXCEPT;
+    void removeFreeBlock(TlsfBlock* const block) NOEXCEPT;
+    TlsfBlock* findFreeBlock(const size_t size) NOEXCEPT;
+    bool grow(const size_t size) NOEXCEPT;
+
+public:
+    // Biggest region the allocator can manage
+    static const size_t MaxSize = static_cast<size_t>(1) << (FirstLevelCount + SecondLevelCountLog2 + GranularityLog2 - 1);
+
+    struct DefaultInstance {
+        static TlsfAllocator* defaultInstance;
+
+        // Only the peak usage gets committed
+        static const size_t DefaultReserveSize = sizeof(void*) >= 8
+            ? static_cast<size_t>(1) * 1024 * 1024 * 1024
+            : 64 * 1024 * 1024;
+
+        template <typename Allocator>
+        DefaultInstance(Allocator& alloc) {
+            assert(("Trying to initialize default instance twice", !defaultInstance));
+            void* const memory =
+                alloc.allocate(sizeof(TlsfAllocator), std::alignment_of<TlsfAllocator>::value, 0);
+            defaultInstance = new (memory) TlsfAllocator(DefaultReserveSize, VirtualMemory::NormalPages, "TLSF heap");
+        }
+        ~DefaultInstance();
+    };
+
+    static TlsfAllocator& getDefault();
+
+    TlsfAllocator(void* const start, void* const end, const char* const name = "TlsfAllocator") NOEXCEPT;
+
+    // Takes a sub-range of the given allocator
+    template <typename Allocator>
+    TlsfAllocator(Allocator& alloc, const size_t size, const char* const name = "TlsfAllocator") :
+        _memory {static_cast<uint8_t*>(alloc.allocate(size, Granularity, 0))},
+        _size {size & ~(Granularity - 1)},
+        _committed {_size},
+        _commitGranularity {0},
+        _used {0},
+        _telemetry {name}
+    {
+        init();
+    }
+
+    // Reserves address space and commits it when free blocks run out
+    TlsfAllocator(const size_t reserveSize,
+                  const VirtualMemory::PageKind kind,
+                  const char* const name = "TlsfAllocator") NOEXCEPT;
+
+    ~TlsfAllocator();
+
+    // Returns nullptr if there is no free block big enough
+    void* allocate(const size_t size, const size_t alignment, const size_t offset) NOEXCEPT;
+    void free(void* const data) NOEXCEPT;
+
+    // Bytes taken by allocated blocks, headers and padding included
+    size_t usedSize() const NOEXCEPT;
+
+    size_t committedSize() const NOEXCEPT;
+};
+
+#endif // TlsfAllocator_h__
@@ -0,0 +1,89 @@
+#include "VirtualMemory.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "SDL_platform.h"
+
+#ifdef __WIN32__
+#  include "SDL_windows.h"
+#else
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif //__WIN32__
+
+static const size_t MinCommitGranularity = 64 * 1024;
+static const size_t HugePageSize = 2 * 1024 * 1024;
+
+size_t VirtualMemory::pageSize() {
+#ifdef __WIN32__
+    static const size_t size = [] {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return static_cast<size_t>(info.dwPageSize);
+    }();
+#else
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif //__WIN32__
+    return size;
+}
+
+size_t VirtualMemory::commitGranularity(const PageKind kind) {
+    const size_t granularity = std::max(pageSize(), MinCommitGranularity);
+    return kind == HugePages ? std::max(granularity, HugePageSize) : granularity;
+}
+
+void* VirtualMemory::reserve(const size_t size, const PageKind kind) {
+#ifdef __WIN32__
+    //XXX: large pages on Windows can't be committed on demand, so they are not used
+    (void) kind;
+    return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void* const address = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+    if (address == MAP_FAILED)
+        return nullptr;
+
+#  ifdef MADV_HUGEPAGE
+    if (kind == HugePages)
+        madvise(address, size, MADV_HUGEPAGE);
+#  else
+    (void) kind;
+#  endif // MADV_HUGEPAGE
+
+    return address;
+#endif //__WIN32__
+}
+
+void VirtualMemory::release(void* const address, const size_t size) {
+#ifdef __WIN32__
+    (void) size;
+    const bool released = VirtualFree(address, 0, MEM_RELEASE) != 0;
+#else
+    const bool released = munmap(address, size) == 0;
+#endif //__WIN32__
+    assert(("Could not release address space", released));
+}
+
+bool VirtualMemory::commit(void* const address, const size_t size) {
+    assert(("Committed range must be page aligned",
+            reinterpret_cast<size_t>(address) % pageSize() == 0 && size % pageSize() == 0));
+
+#ifdef __WIN32__
+    return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+    return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+#endif //__WIN32__
+}
+
+void VirtualMemory::decommit(void* const address, const size_t size) {
+    assert(("Decommitted range must be page aligned",
+            reinterpret_cast<size_t>(address) % pageSize() == 0 && size % pageSize() == 0));
+
+#ifdef __WIN32__
+    VirtualFree(address, size, MEM_DECOMMIT);
+#else
+    // drop the pages first, protecting them alone keeps them resident
+    madvise(address, size, MADV_DONTNEED);
+    mprotect(address, size, PROT_NONE);
+#endif //__WIN32__
+}
@@ -0,0 +1,32 @@
+#ifndef VirtualMemory_h__
+#define VirtualMemory_h__
+
+#include <cstdlib>
+
+// Thin wrapper over OS virtual memory. Reserved address space is not backed by memory
+// until it is committed, decommitted pages give their memory back to the OS but stay reserved
+namespace VirtualMemory
+{
+    enum PageKind {
+        NormalPages,
+
+        // Asks the OS to back the range with huge pages where it is supported,
+        // falls back to normal pages otherwise
+        HugePages
+    };
+
+    size_t pageSize();
+
+    // Allocators commit memory in steps of this size to keep the number of system calls low
+    size_t commitGranularity(const PageKind kind);
+
+    // Returns nullptr if the address space could not be reserved
+    void* reserve(const size_t size, const PageKind kind);
+    void release(void* const address, const size_t size);
+
+    // Address and size must be multiples of page size
+    bool commit(void* const address, const size_t size);
+    void decommit(void* const address, const size_t size);
+}
+
+#endif // VirtualMemory_h__
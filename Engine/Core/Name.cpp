@@ -0,0 +1,97 @@
+#include "Name.hpp"
+
+#include <cstring>
+#include <thread>
+
+#include "SDL_log.h"
+
+#include "HashNames.hpp"
+#include "Util/ptr_util.hpp"
+
+NameTable* NameTable::DefaultInstance::defaultInstance;
+
+NameTable::DefaultInstance::~DefaultInstance() {
+    assert(("Default instance already destroyed", defaultInstance));
+    defaultInstance->~NameTable();
+    defaultInstance = nullptr;
+}
+
+NameTable& NameTable::getDefault() {
+    return *DefaultInstance::defaultInstance;
+}
+
+Name::Name(const char* const string) :
+    Name {string, strlen(string)}
+{}
+
+Name::Name(const char* const string, const size_t length) :
+    _entry {length ? NameTable::getDefault().intern(string, length) : nullptr}
+{}
+
+Name::Name(const String& string) :
+    Name {string.begin(), string.size()}
+{}
+
+inline static bool matches(const Name::Entry* const entry,
+                           const uint32_t hash,
+                           const char* const string,
+                           const size_t length) {
+    return entry->hash == hash && entry->length == length && memcmp(entry->string(), string, length) == 0;
+}
+
+const Name::Entry* NameTable::intern(const char* const string, const size_t length) NOEXCEPT {
+    const uint32_t hash = util::hash(string, length, util::NameHashSeed);
+
+    size_t slot = hash & SlotMask;
+    for (;;) {
+        const Name::Entry* const entry = _slots[slot].load(std::memory_order_acquire);
+        if (!entry)
+            break;
+
+        if (matches(entry, hash, string, length))
+            return entry;
+
+        slot = (slot + 1) & SlotMask;
+    }
+
+    while (_insertLock.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    // slots before this one were checked already and can't change
+    for (;;) {
+        const Name::Entry* const entry = _slots[slot].load(std::memory_order_relaxed);
+        if (!entry)
+            break;
+
+        if (matches(entry, hash, string, length)) {
+            _insertLock.clear(std::memory_order_release);
+            return entry;
+        }
+
+        slot = (slot + 1) & SlotMask;
+    }
+
+    const size_t entrySize = util::alignUp(sizeof(Name::Entry) + length + 1, EntryAlignment);
+    if (_count == MaxNameCount || _used + entrySize > _storageSize) {
+        _insertLock.clear(std::memory_order_release);
+        SDL_Log("Name table is full, can't add %.*s", static_cast<int>(length), string);
+        return nullptr;
+    }
+
+    auto entry = reinterpret_cast<Name::Entry*>(_storage + _used);
+    entry->hash = hash;
+    entry->length = static_cast<uint32_t>(length);
+
+    char* const copy = const_cast<char*>(entry->string());
+    memcpy(copy, string, length);
+    copy[length] = '\0';
+
+    _used += entrySize;
+    ++_count;
+
+    _slots[slot].store(entry, std::memory_order_release);
+    _insertLock.clear(std::memory_order_release);
+
+    HashNames::remember(hash, string, length);
+    return entry;
+}
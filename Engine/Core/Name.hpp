@@ -0,0 +1,146 @@
+#ifndef Name_h__
+#define Name_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#include "String.hpp"
+#include "Util/defines.hpp"
+#include "Util/hash.hpp"
+#include "Util/noncopyable.hpp"
+
+// Interned string. Every distinct string is stored once in the name table and lives
+// as long as the table, so names are cheap to copy and compare by pointer.
+// Hash of the string is kept with it and is the same as "string"_h.
+// Name of a string which doesn't fit into a full table is empty
+class Name {
+public:
+    struct Entry {
+        uint32_t hash;
+        uint32_t length;
+
+        // Null terminated string follows the entry
+        REALLY_INLINE const char* string() const NOEXCEPT {
+            return reinterpret_cast<const char*>(this + 1);
+        }
+    };
+
+private:
+    // Null for the empty name
+    const Entry* _entry;
+
+public:
+    Name() NOEXCEPT :
+        _entry {nullptr}
+    {}
+
+    explicit Name(const char* const string);
+    Name(const char* const string, const size_t length);
+    explicit Name(const String& string);
+
+    REALLY_INLINE bool operator ==(const Name& other) const NOEXCEPT {
+        return _entry == other._entry;
+    }
+
+    REALLY_INLINE bool operator !=(const Name& other) const NOEXCEPT {
+        return _entry != other._entry;
+    }
+
+    REALLY_INLINE uint32_t hash() const NOEXCEPT {
+        return _entry ? _entry->hash : ""_h;
+    }
+
+    REALLY_INLINE const char* c_str() const NOEXCEPT {
+        return _entry ? _entry->string() : "";
+    }
+
+    REALLY_INLINE size_t size() const NOEXCEPT {
+        return _entry ? _entry->length : 0;
+    }
+
+    REALLY_INLINE bool empty() const NOEXCEPT {
+        return !_entry;
+    }
+
+    REALLY_INLINE const char* begin() const NOEXCEPT {
+        return c_str();
+    }
+
+    REALLY_INLINE const char* end() const NOEXCEPT {
+        return c_str() + size();
+    }
+};
+
+// Open addressing table of interned strings with arena storage.
+//
+// Slots are only ever filled, never emptied, so lookups probe without locking and
+// see either an empty slot or a complete entry. Adding a new name takes a spinlock
+// and probes again from where the lookup stopped, other threads may have added it meanwhile
+class NameTable : public util::Noncopyable {
+public:
+    static const size_t MaxNameCount = 16384;
+
+    // Entry header and null terminator included, resource paths are mostly shorter
+    static const size_t AverageNameSize = 64;
+
+private:
+    // Table is kept at most half full
+    static const size_t SlotCount = MaxNameCount * 2;
+    static const size_t SlotMask = SlotCount - 1;
+
+    static const size_t EntryAlignment = std::alignment_of<Name::Entry>::value;
+
+    std::atomic<const Name::Entry*>* const _slots;
+
+    uint8_t* const _storage;
+    const size_t _storageSize;
+    size_t _used;
+    size_t _count;
+
+    std::atomic_flag _insertLock;
+
+public:
+    struct DefaultInstance {
+        static NameTable* defaultInstance;
+
+        static const size_t DefaultStorageSize = MaxNameCount * AverageNameSize;
+
+        template <typename Allocator>
+        DefaultInstance(Allocator& alloc) {
+            assert(("Trying to initialize default instance twice", !defaultInstance));
+            void* const memory =
+                alloc.allocate(sizeof(NameTable), std::alignment_of<NameTable>::value, 0);
+            defaultInstance = new (memory) NameTable(alloc, DefaultStorageSize);
+        }
+        ~DefaultInstance();
+    };
+
+    static NameTable& getDefault();
+
+    template <typename Allocator>
+    NameTable(Allocator& alloc, const size_t storageSize) :
+        _slots {static_cast<std::atomic<const Name::Entry*>*>(
+            alloc.allocate(sizeof(std::atomic<const Name::Entry*>) * SlotCount,
+                           std::alignment_of<std::atomic<const Name::Entry*>>::value,
+                           0))},
+        _storage {static_cast<uint8_t*>(alloc.allocate(storageSize, EntryAlignment, 0))},
+        _storageSize {storageSize},
+        _used {0},
+        _count {0}
+    {
+        for (size_t i = 0; i < SlotCount; ++i)
+            new (&_slots[i]) std::atomic<const Name::Entry*>(nullptr);
+
+        _insertLock.clear();
+    }
+
+    // Returns the entry of the string and adds it if the string is new, can be called from any thread.
+    // Returns nullptr if the string is new and there is no room left for it
+    const Name::Entry* intern(const char* const string, const size_t length) NOEXCEPT;
+};
+
+#endif // Name_h__
@@ -0,0 +1,165 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "SDL_log.h"
+#include "SDL_timer.h"
+
+#include "Core/String.hpp"
+#include "IO/FileUtils.h"
+#include "IO/Stream.hpp"
+
+// std::min takes it by reference
+const size_t Profiler::MaxThreadCount;
+
+// ring of the current thread and the profiler it belongs to
+static thread_local const Profiler* currentProfiler = nullptr;
+static thread_local void* currentThreadRing = nullptr;
+
+static const size_t LineBufferSize = 256;
+
+uint64_t Profiler::currentTicks() {
+    return SDL_GetPerformanceCounter();
+}
+
+Profiler::ThreadRing* Profiler::currentRing() {
+    if (currentProfiler == this)
+        return static_cast<ThreadRing*>(currentThreadRing);
+
+    currentProfiler = this;
+    currentThreadRing = nullptr;
+
+    // threads never give their rings back, late threads are not recorded
+    if (_threadCount.load(std::memory_order_relaxed) < MaxThreadCount) {
+        const size_t index = _threadCount.fetch_add(1, std::memory_order_relaxed);
+        if (index < MaxThreadCount)
+            currentThreadRing = &_rings[index];
+    }
+
+    return static_cast<ThreadRing*>(currentThreadRing);
+}
+
+void Profiler::record(const EventType type, const char* const name) NOEXCEPT {
+    Profiler* const profiler = DefaultInstance::defaultInstance;
+    if (!profiler)
+        return;
+
+    ThreadRing* const ring = profiler->currentRing();
+    if (!ring)
+        return;
+
+    const uint64_t head = ring->head.load(std::memory_order_relaxed);
+    Event& event = ring->events[head & (MaxEventCount - 1)];
+
+    // event being overwritten was published by the previous head store,
+    // dump pairs with this fence to notice that the slot was reused
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.name.store(name, std::memory_order_relaxed);
+    event.ticks.store(currentTicks(), std::memory_order_relaxed);
+    event.type.store(type, std::memory_order_relaxed);
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const char* const name) NOEXCEPT {
+    Profiler* const profiler = DefaultInstance::defaultInstance;
+    if (!profiler)
+        return;
+
+    ThreadRing* const ring = profiler->currentRing();
+    if (ring)
+        ring->name.store(name, std::memory_order_relaxed);
+}
+
+// Returns false if the line didn't fit into the buffer and was skipped,
+// cutting it would leave broken JSON
+static bool writeLine(Stream& stream, const char* const line, const int length) {
+    if (length <= 0 || static_cast<size_t>(length) >= LineBufferSize)
+        return false;
+
+    stream.writeFrom(reinterpret_cast<const uint8_t*>(line), static_cast<size_t>(length));
+    return true;
+}
+
+bool Profiler::dump(const char* const fileName) const {
+    Stream stream = Stream::fromFile(FileUtils::writableDataPath(fileName), "wb");
+    if (!stream.isValid())
+        return false;
+
+    static const char* const phases[] = {"B", "E"};
+
+    //XXX: names are written as is, they are not expected to contain characters that need escaping
+    char line[LineBufferSize];
+    const double ticksPerMicrosecond = static_cast<double>(SDL_GetPerformanceFrequency()) / 1000000.0;
+
+    const char header[] = "{\"traceEvents\":[\n";
+    writeLine(stream, header, sizeof(header) - 1);
+
+    bool first = true;
+    size_t skippedCount = 0;
+    const size_t threadCount = std::min(_threadCount.load(std::memory_order_acquire), MaxThreadCount);
+    for (size_t thread = 0; thread < threadCount; ++thread) {
+        const ThreadRing& ring = _rings[thread];
+
+        const char* const threadName = ring.name.load(std::memory_order_relaxed);
+        if (threadName) {
+            const int length = snprintf(line, LineBufferSize,
+                "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", static_cast<unsigned>(thread), threadName);
+            if (writeLine(stream, line, length))
+                first = false;
+            else
+                ++skippedCount;
+        }
+
+        const uint64_t head = ring.head.load(std::memory_order_acquire);
+        const uint64_t begin = head > MaxEventCount ? head - MaxEventCount : 0;
+
+        for (uint64_t i = begin; i < head; ++i) {
+            const Event& event = ring.events[i & (MaxEventCount - 1)];
+
+            const char* const name = event.name.load(std::memory_order_relaxed);
+            const uint64_t ticks = event.ticks.load(std::memory_order_relaxed);
+            const uint32_t type = event.type.load(std::memory_order_relaxed);
+
+            // skip the event if its slot was reused while we were reading it
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (i + MaxEventCount <= ring.head.load(std::memory_order_relaxed))
+                continue;
+
+            const double timestamp = static_cast<double>(ticks - _startTicks) / ticksPerMicrosecond;
+            const int length = type == FrameMark
+                ? snprintf(line, LineBufferSize,
+                    "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+                    first ? "" : ",\n", name, timestamp, static_cast<unsigned>(thread))
+                : snprintf(line, LineBufferSize,
+                    "%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+                    first ? "" : ",\n", name, phases[type], timestamp, static_cast<unsigned>(thread));
+            if (writeLine(stream, line, length))
+                first = false;
+            else
+                ++skippedCount;
+        }
+    }
+
+    if (skippedCount)
+        SDL_Log("Profiler skipped %u events with names too long to write", static_cast<unsigned>(skippedCount));
+
+    const char footer[] = "\n]}\n";
+    writeLine(stream, footer, sizeof(footer) - 1);
+    return true;
+}
+
+Profiler* Profiler::DefaultInstance::defaultInstance;
+
+Profiler::DefaultInstance::~DefaultInstance() {
+    assert(("Default instance already destroyed", defaultInstance));
+    defaultInstance->~Profiler();
+    defaultInstance = nullptr;
+}
+
+Profiler& Profiler::getDefault() {
+    return *DefaultInstance::defaultInstance;
+}
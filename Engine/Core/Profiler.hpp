@@ -0,0 +1,131 @@
+#ifndef Profiler_h__
+#define Profiler_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+// Records scoped zones, jobs and frame markers of every thread and dumps them
+// in Chrome trace event format (load the file in chrome://tracing or Perfetto).
+//
+// Every thread writes to its own ring buffer, when it wraps around the oldest
+// events are overwritten. Instrumentation is done with PROFILE_* macros which
+// compile to nothing unless ENABLE_PROFILER is defined
+class Profiler : public util::Noncopyable {
+public:
+    enum EventType {
+        ZoneBegin,
+        ZoneEnd,
+        FrameMark
+    };
+
+private:
+    static const size_t MaxThreadCount = 40;
+    static const size_t MaxEventCount = 4096;
+    static_assert((MaxEventCount & (MaxEventCount - 1)) == 0, "MaxEventCount must be power of two");
+
+    static const size_t CacheLineSize = 64;
+
+    // Fields are written by the owning thread and read by dump at the same time,
+    // relaxed atomics keep them plain stores
+    struct Event {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> ticks;
+        std::atomic<uint32_t> type;
+    };
+
+    struct ThreadRing {
+        Event* events;
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> head;
+        uint8_t _pad[CacheLineSize - sizeof(Event*) - sizeof(std::atomic<const char*>) - sizeof(std::atomic<uint64_t>)];
+    };
+
+    static const size_t EventAlignment = std::alignment_of<Event>::value;
+    static const size_t RingAlignment = std::alignment_of<ThreadRing>::value;
+
+    ThreadRing* const _rings;
+    std::atomic<size_t> _threadCount;
+    const uint64_t _startTicks;
+
+    static uint64_t currentTicks();
+
+    ThreadRing* currentRing();
+
+public:
+    struct DefaultInstance {
+        static Profiler* defaultInstance;
+
+        template <typename Allocator>
+        DefaultInstance(Allocator& alloc) {
+            assert(("Trying to initialize default instance twice", !defaultInstance));
+            void* const memory =
+                alloc.allocate(sizeof(Profiler), std::alignment_of<Profiler>::value, 0);
+            defaultInstance = new (memory) Profiler(alloc);
+        }
+        ~DefaultInstance();
+    };
+
+    static Profiler& getDefault();
+
+    template <typename Allocator>
+    explicit Profiler(Allocator& alloc) :
+        _rings {static_cast<ThreadRing*>(alloc.allocate(MaxThreadCount * sizeof(ThreadRing), RingAlignment, 0))},
+        _threadCount {0},
+        _startTicks {currentTicks()}
+    {
+        for (size_t i = 0; i < MaxThreadCount; ++i) {
+            new (&_rings[i]) ThreadRing();
+            _rings[i].events =
+                static_cast<Event*>(alloc.allocate(MaxEventCount * sizeof(Event), EventAlignment, 0));
+            for (size_t j = 0; j < MaxEventCount; ++j)
+                new (&_rings[i].events[j]) Event();
+
+            _rings[i].name.store(nullptr, std::memory_order_relaxed);
+            _rings[i].head.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Names must be string literals or otherwise outlive the profiler.
+    // Events of threads started after MaxThreadCount others are dropped
+    static void record(const EventType type, const char* const name) NOEXCEPT;
+    static void setThreadName(const char* const name) NOEXCEPT;
+
+    // Writes Chrome trace JSON into the writable folder. Can be called while other threads
+    // are still recording, events overwritten during the dump are skipped
+    bool dump(const char* const fileName) const;
+};
+
+class ProfileZone : public util::Noncopyable {
+    const char* const _name;
+
+public:
+    explicit ProfileZone(const char* const name) NOEXCEPT :
+        _name {name}
+    {
+        Profiler::record(Profiler::ZoneBegin, _name);
+    }
+
+    ~ProfileZone() {
+        Profiler::record(Profiler::ZoneEnd, _name);
+    }
+};
+
+#ifdef ENABLE_PROFILER
+#  define PROFILE_CONCAT_IMPL(a, b) a##b
+#  define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#  define PROFILE_ZONE(name) const ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#  define PROFILE_FRAME(name) Profiler::record(Profiler::FrameMark, name)
+#  define PROFILE_THREAD(name) Profiler::setThreadName(name)
+#else
+#  define PROFILE_ZONE(name) ((void)0)
+#  define PROFILE_FRAME(name) ((void)0)
+#  define PROFILE_THREAD(name) ((void)0)
+#endif // ENABLE_PROFILER
+
+#endif // Profiler_h__
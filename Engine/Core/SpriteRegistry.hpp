@@ -1,12 +1,12 @@
 #ifndef SpriteRegistry_h__
 #define SpriteRegistry_h__
 
-#include "Util/Registry.hpp"
+#include "Util/ConcurrentRegistry.hpp"
 
 static const size_t MaxSpriteCount = 4096;
 
 struct Sprite;
 
-typedef util::Registry<Sprite, MaxSpriteCount> SpriteRegistry;
+typedef util::ConcurrentRegistry<Sprite, MaxSpriteCount> SpriteRegistry;
 
 #endif // SpriteRegistry_h__
\ No newline at end of file
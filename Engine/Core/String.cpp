@@ -60,17 +60,21 @@ String& String::init(const char* const string, const size_t length, const InitPo
 }
 
 String String::concatenate(const char* const string, const size_t length) const {
-    const size_t oldLength = header()->length;
-    const size_t newLength = oldLength + length;
+    return join(_data, header()->length, string, length);
+}
+
+String String::join(const char* const first, const size_t firstLength,
+                    const char* const second, const size_t secondLength) {
+    const size_t length = firstLength + secondLength;
 
-    char* buffer = allocate(newLength);
+    char* buffer = allocate(length);
 
-    memcpy(buffer, _data, oldLength);
-    memcpy(buffer + oldLength, string, length);
+    memcpy(buffer, first, firstLength);
+    memcpy(buffer + firstLength, second, secondLength);
 
-    buffer[newLength] = '\0';
+    buffer[length] = '\0';
 
-    return String().init(buffer, newLength, NoCopy);
+    return String().init(buffer, length, NoCopy);
 }
 
 String::String() :
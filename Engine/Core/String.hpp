@@ -63,6 +63,10 @@ public:
     String(String&& other);
     ~String();
 
+    // Concatenates two strings with a single allocation
+    static String join(const char* const first, const size_t firstLength,
+                       const char* const second, const size_t secondLength);
+
     String& operator =(const String& other);
     String& operator =(String&& other);
     String& operator =(const ConstChar& string);
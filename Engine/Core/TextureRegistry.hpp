@@ -1,12 +1,12 @@
 #ifndef TextureRegistry_h__
 #define TextureRegistry_h__
 
-#include "Util/Registry.hpp"
+#include "Util/ConcurrentRegistry.hpp"
 
 static const size_t MaxTextureCount = 64;
 
 struct Texture;
 
-typedef util::Registry<Texture, MaxTextureCount> TextureRegistry;
+typedef util::ConcurrentRegistry<Texture, MaxTextureCount> TextureRegistry;
 
 #endif // TextureRegistry_h__
\ No newline at end of file
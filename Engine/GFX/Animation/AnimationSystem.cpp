@@ -1,6 +1,10 @@
 #include "GFX/Animation/AnimationSystem.hpp"
 
+#include "SDL_log.h"
+
 #include "Core/ClipRegistry.hpp"
+#include "Core/Concurrency/ParallelFor.hpp"
+#include "Core/HashNames.hpp"
 #include "GFX/Color.hpp"
 #include "Geom/Matrix2D.hpp"
 #include "Geom/Vector2D.hpp"
@@ -48,33 +52,7 @@ uint32_t advanceTime(AnimationSystem::AnimationState* const state,
 AnimationSystem::Handle AnimationSystem::startAnimation(const uint32_t clipHash,
                                                         const uint32_t animationHash,
                                                         const bool cycle) {
-    assert(("Maximum animation count reached", clipCount < MaxPlayingClipCount));
-
-    // We are swapping element at last playing position
-    // and last paused position
-    //
-    // [rrrrrrrrr[p]pppppp[.].....]
-    //          ^        ^
-    //          |        --clipCount
-    //          --playingClipCount
-    //
-    // [rrrrrrrrr[.]pppppp[p].....]
-    //            ^        ^
-    //            |        --clipCount
-    //            --playingClipCount
-    //
-    // and initializing a new animation in the empty space
-    lookup[handleIndeces[clipCount]] = lookup[handleIndeces[playingClipCount]];
-    clips[clipCount] = clips[playingClipCount];
-
-    const Handle oldHandle = lookup[firstFreeIndex];
-    const Handle newHandle = { playingClipCount, static_cast<uint16_t>(oldHandle.cycle + 1) };
-
-    AnimationState* nodes = nodeStates + (firstFreeIndex * MaxClipNodeCount);
-    lookup[firstFreeIndex] = newHandle;
-
-    handleIndeces[playingClipCount] = firstFreeIndex;
-    firstFreeIndex = oldHandle.index;
+    assert(("Maximum animation count reached", clips.size() < MaxPlayingClipCount));
 
     const Clip* prototype = ClipRegistry::getDefault().resourceForHandle(clipHash);
     assert(("Invalid clip handle", prototype));
@@ -85,15 +63,20 @@ AnimationSystem::Handle AnimationSystem::startAnimation(const uint32_t clipHash,
                                                   [](const Animation& animation, const uint32_t hash){
                                                       return animation.nameHash < hash;
                                                   });
-    assert(("Invalid animation handle", animation != prototype->animations + prototype->animationCount));
-    assert(("Invalid animation handle", animation->nameHash == animationHash));
-
-    auto clip = PlayingClip{ nodes,
-                             prototype,
-                             animation->sampleStream + sizeof(float),
-                             0,
-                             0,
-                             0 };
+    if (animation == prototype->animations + prototype->animationCount || animation->nameHash != animationHash) {
+        SDL_Log("No animation %s in clip %s", HashNames::name(animationHash), HashNames::name(clipHash));
+        assert(("Invalid animation handle", false));
+    }
+
+    const Handle handle = clips.insert(PlayingClip{ nullptr,
+                                                    prototype,
+                                                    animation->sampleStream + sizeof(float),
+                                                    0,
+                                                    0,
+                                                    0 });
+
+    PlayingClip& clip = clips.get(handle);
+    clip.nodeStates = nodeStates + (handle.index * MaxClipNodeCount);
     readFromStream(animation->sampleStream, 0, &clip.timeScale);
 
     clip.playhead = ::advanceTime(clip.nodeStates,
@@ -101,82 +84,60 @@ AnimationSystem::Handle AnimationSystem::startAnimation(const uint32_t clipHash,
                                   clip.sampleStream,
                                   clip.playhead);
 
-    clips[playingClipCount] = clip;
-
+    // New clip is added to the end, we are swapping it with the first paused one
+    //
+    // [rrrrrrrrr[p]pppppp[N].....]
+    //          ^            ^
+    //          |            --clips.size()
+    //          --playingClipCount
+    //
+    // [rrrrrrrrr[N]pppppp[p].....]
+    //           ^           ^
+    //           |           --clips.size()
+    //           --playingClipCount
+    clips.swapItems(clips.indexOf(handle), playingClipCount);
     ++playingClipCount;
-    ++clipCount;
 
-    return newHandle;
+    return handle;
 }
 
 void AnimationSystem::stopAnimation(const AnimationSystem::Handle handle) {
-    const auto storedHandle = lookup[handle.index];
-    assert(("Invalid animation handle", storedHandle.index < clipCount));
-    assert(("Using handle of destroyed animation", storedHandle.cycle == handle.cycle));
-
-    --playingClipCount;
-    --clipCount;
+    assert(("Using handle of destroyed animation", clips.contains(handle)));
 
-    if (storedHandle.index <= playingClipCount) {
-        // If it were playing we have to perform two swaps
-        // First we swap with last playing element
+    const size_t index = clips.indexOf(handle);
+    if (index < playingClipCount) {
+        // If it were playing we have to swap with last playing element first
         //
         // [rrr[S]rrrr[r]ppppppp......]
         //             ^       ^
-        //             |       --clipCount
+        //             |       --clips.size()
         //             --playingClipCount
         //
         // [rrr[r]rrrr[S]ppppppp......]
-        //             ^       ^
-        //             |       --clipCount
-        //             --playingClipCount
-        std::swap(clips[storedHandle.index], clips[playingClipCount]);
-        std::swap(handleIndeces[storedHandle.index], handleIndeces[playingClipCount]);
-        std::swap(lookup[handleIndeces[storedHandle.index]], lookup[handleIndeces[playingClipCount]]);
-
-        // Then swap with the last paused element moves the animation to the end, where
-        // its destroyed
-        //
-        // [rrrrrrrr[S]pppppp[p]......]
-        //           ^        ^
-        //           |        --clipCount
+        //           ^         ^
+        //           |         --clips.size()
         //           --playingClipCount
-        //
-        // [rrrrrrrr[p]pppppp[S]......]
-        //         ^        ^
-        //         |        --clipCount
-        //         --playingClipCount
-        std::swap(clips[clipCount], clips[playingClipCount]);
-        std::swap(handleIndeces[clipCount], handleIndeces[playingClipCount]);
-        std::swap(lookup[handleIndeces[clipCount]], lookup[handleIndeces[playingClipCount]]);
-    } else {
-        // If the stopped animation was pausedd we can perform only one swap
-        // with the last paused element
-        //
-        // [rrrrrrrrppp[S]pppp[p]......]
-        //         ^           ^
-        //         |           --clipCount
-        //         --playingClipCount
-        //
-        // [rrrrrrrrppp[p]pppp[S]......]
-        //         ^         ^
-        //         |         --clipCount
-        //         --playingClipCount
-        std::swap(clips[clipCount], clips[storedHandle.index]);
-        std::swap(handleIndeces[clipCount], handleIndeces[storedHandle.index]);
-        std::swap(lookup[handleIndeces[clipCount]], lookup[handleIndeces[storedHandle.index]]);
-   }
-
-    lookup[handleIndeces[clipCount]].index = firstFreeIndex;
-    firstFreeIndex = handleIndeces[clipCount];
+        --playingClipCount;
+        clips.swapItems(index, playingClipCount);
+    }
+
+    // Removing moves the last paused element into the gap
+    //
+    // [rrrrrrrrppp[S]pppp[p]......]
+    //         ^            ^
+    //         |            --clips.size()
+    //         --playingClipCount
+    //
+    // [rrrrrrrrppp[p]pppp......]
+    //         ^         ^
+    //         |         --clips.size()
+    //         --playingClipCount
+    clips.erase(handle);
 }
 
 bool AnimationSystem::pauseAnimation(const AnimationSystem::Handle handle) {
-    const auto storedHandle = lookup[handle.index];
-    assert(("Invalid animation handle", storedHandle.index < clipCount));
-    assert(("Using handle of destroyed animation", storedHandle.cycle == handle.cycle));
-
-    if (storedHandle.index >= playingClipCount)
+    const size_t index = clips.indexOf(handle);
+    if (index >= playingClipCount)
         return false;
 
     --playingClipCount;
@@ -185,42 +146,35 @@ bool AnimationSystem::pauseAnimation(const AnimationSystem::Handle handle) {
     //
     // [rrr[P]rrrr[r]ppppppp......]
     //             ^       ^
-    //             |       --clipCount
+    //             |       --clips.size()
     //             --playingClipCount
     //
     // [rrr[r]rrrr[P]ppppppp......]
     //           ^         ^
-    //           |         --clipCount
+    //           |         --clips.size()
     //           --playingClipCount
-    std::swap(clips[storedHandle.index], clips[playingClipCount]);
-    std::swap(handleIndeces[storedHandle.index], handleIndeces[playingClipCount]);
-    std::swap(lookup[handleIndeces[storedHandle.index]], lookup[handleIndeces[playingClipCount]]);
+    clips.swapItems(index, playingClipCount);
 
     return true;
 }
 
 bool AnimationSystem::resumeAnimation(const AnimationSystem::Handle handle) {
-    const auto storedHandle = lookup[handle.index];
-    assert(("Invalid animation handle", storedHandle.index < clipCount));
-    assert(("Using handle of destroyed animation", storedHandle.cycle == handle.cycle));
-
-    if (storedHandle.index < playingClipCount)
+    const size_t index = clips.indexOf(handle);
+    if (index < playingClipCount)
         return false;
 
     // We are swapping with first paused element
     //
     // [rrrrrrrrr[p]ppp[R]pp......]
     //          ^          ^
-    //          |          --clipCount
+    //          |          --clips.size()
     //           --playingClipCount
     //
     // [rrrrrrrrr[R]ppp[p]pp......]
     //            ^        ^
-    //            |        --clipCount
+    //            |        --clips.size()
     //             --playingClipCount
-    std::swap(clips[storedHandle.index], clips[playingClipCount]);
-    std::swap(handleIndeces[storedHandle.index], handleIndeces[playingClipCount]);
-    std::swap(lookup[handleIndeces[storedHandle.index]], lookup[handleIndeces[playingClipCount]]);
+    clips.swapItems(index, playingClipCount);
 
     ++playingClipCount;
 
@@ -228,15 +182,18 @@ bool AnimationSystem::resumeAnimation(const AnimationSystem::Handle handle) {
 }
 
 void AnimationSystem::advanceTime(const float delta) {
-    for (size_t i = 0; i < playingClipCount; ++i) {
-        PlayingClip& clip = clips[i];
-
-        clip.time += delta * clip.timeScale;
-        clip.playhead = ::advanceTime(clip.nodeStates,
-                                      clip.time,
-                                      clip.sampleStream,
-                                      clip.playhead);
-    }
+    // clips own their node states, so they can be advanced independently
+    parallel_for(0, playingClipCount, 0, [=](const size_t from, const size_t to) {
+        for (size_t i = from; i < to; ++i) {
+            PlayingClip& clip = clips[i];
+
+            clip.time += delta * clip.timeScale;
+            clip.playhead = ::advanceTime(clip.nodeStates,
+                                          clip.time,
+                                          clip.sampleStream,
+                                          clip.playhead);
+        }
+    });
 }
 
 REALLY_INLINE static float progress(const uint16_t start, const uint16_t end, const uint8_t time) {
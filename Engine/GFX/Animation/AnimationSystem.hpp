@@ -6,6 +6,7 @@
 #include <limits>
 #include <new>
 
+#include "Util/SlotMap.hpp"
 #include "Util/noncopyable.hpp"
 #include "GFX/Animation/Sample.hpp"
 
@@ -29,10 +30,7 @@ struct Clip {
 
 class AnimationSystem : util::Noncopyable {
 public:
-    struct Handle {
-        uint16_t index : 9;
-        uint16_t cycle : 7;
-    };
+    typedef util::SlotHandle Handle;
 
     struct AnimationState {
         uint16_t timeStart;
@@ -54,15 +52,6 @@ private:
     static const size_t MaxPlayingClipCount = 16 * 1024;
     static const size_t MaxClipNodeCount = 256;
 
-    static const size_t PlayingClipsStorageSize = MaxPlayingClipCount * sizeof(PlayingClip);
-    static const size_t PlayingClipsAlignment = std::alignment_of<PlayingClip>::value;
-
-    static const size_t HandleIndecesStorageSize = MaxPlayingClipCount * sizeof(uint16_t);
-    static const size_t HandleIndecesAlignment = std::alignment_of<uint16_t>::value;
-
-    static const size_t LookupStorageSize = MaxPlayingClipCount * sizeof(Handle);
-    static const size_t LookupAlignment = std::alignment_of<Handle>::value;
-
     static const size_t NodeStatesStorageSize = MaxPlayingClipCount * MaxClipNodeCount * sizeof(AnimationState);
     static const size_t NodeStateAlignment = std::alignment_of<AnimationState>::value;
 
@@ -71,29 +60,17 @@ private:
     // This way we can process all running animations in one loop
     // [RRRRRRRRRppppppp......]
     //          ^      ^
-    //          |      --clipCount
+    //          |      --clips.size()
     //          --playingClipCount
     //
-    // All animations are controled using a handle
-    // Handles are indexes in a lookup table to decouple handle from the actual address of
-    // the animation it represents
+    // All animations are controled using a slot map handle, so clips can be moved
+    // to keep the array partitioned while add/remove/pause/resume stay O(1)
     //
-    // To allow add/remove/pause/resume operations to be O(1) every running clip has its
-    // handle index in lookup table. When the clip is moved index is used to update the
-    // location handle will point to
-    //
-    // Handle contains an index into clip array and a cycle marker (used for detection of
-    // invalid handles)
-    //
-    // Unused cells in lookup table are used to store index of the next free cell
+    // Node states of a clip belong to its slot, they don't move with the clip
 
-    PlayingClip* clips;
-    uint16_t* handleIndeces;
+    util::SlotMap<PlayingClip> clips;
     AnimationState* nodeStates;
-    Handle* lookup;
     uint16_t playingClipCount;
-    uint16_t clipCount;
-    uint16_t firstFreeIndex;
 
 public:
     struct DefaultInstance {
@@ -120,19 +97,10 @@ public:
 
     template <typename Allocator>
     AnimationSystem(Allocator& alloc) :
-        clips{ reinterpret_cast<PlayingClip*>(alloc.allocate(PlayingClipsStorageSize, PlayingClipsAlignment, 0)) },
-        handleIndeces{ reinterpret_cast<uint16_t*>(alloc.allocate(HandleIndecesStorageSize, HandleIndecesAlignment, 0)) },
+        clips{ alloc, MaxPlayingClipCount },
         nodeStates{ reinterpret_cast<AnimationState*>(alloc.allocate(NodeStatesStorageSize, NodeStateAlignment, 0)) },
-        lookup{ reinterpret_cast<Handle*>(alloc.allocate(LookupStorageSize, LookupAlignment, 0)) },
-        clipCount{ 0 },
-        playingClipCount{ 0 },
-        firstFreeIndex{ 0 }
-    {
-        // initialize lookup table with indeces of the next free cell
-        for (size_t i = 0; i < MaxPlayingClipCount; ++i) {
-            lookup[i] = { static_cast<uint16_t>(i + 1), 0 };
-        }
-    }
+        playingClipCount{ 0 }
+    {}
 
     Handle startAnimation(const uint32_t clip, const uint32_t animation, const bool cycle = false);
     void stopAnimation(const Handle handle);
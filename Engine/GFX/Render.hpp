@@ -3,14 +3,14 @@
 
 #include "SceneGraph.hpp"
 
-class LinearAllocator;
+class ScratchAllocator;
 template <typename Allocator>
 class ScopeStack;
 
 class Window;
 
 struct Render : public util::Noncopyable {
-    typedef ScopeStack<LinearAllocator> ScopeAlloc;
+    typedef ScopeStack<ScratchAllocator> ScopeAlloc;
 
     template <typename Allocator>
     explicit Render(Allocator& alloc) :
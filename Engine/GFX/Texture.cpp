@@ -12,6 +12,10 @@ Texture::Texture(uint32_t* const sprites, const size_t spriteCount) :
     spriteCount {spriteCount}
 {
     assert(("Texture with no sprites", sprites && spriteCount));
+}
+
+Texture::Handle Texture::createHandle() {
+    Handle handle = 0;
     glGenTextures(1, &handle);
     assert(!glGetError() && handle);
 
@@ -19,6 +23,8 @@ Texture::Texture(uint32_t* const sprites, const size_t spriteCount) :
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    return handle;
 }
 
 void Texture::bind(const Handle handle) {
@@ -26,6 +32,21 @@ void Texture::bind(const Handle handle) {
     assert(!glGetError());
 }
 
+size_t Texture::dataSize(const Format format, const Vector2D<size_t>& size) {
+    switch (format) {
+    case Alpha:
+        return size.x * size.y;
+    case Uncompressed:
+        return 4 * size.x * size.y;
+    case Etc1:
+    case Pvrtc:
+        return size.x * size.y / 2;
+    default:
+        assert(("Unknown texture format", false));
+        return 0;
+    }
+}
+
 void Texture::upload(const Handle handle,
                      const uint8_t* const buffer,
                      const Format format,
@@ -37,7 +58,7 @@ void Texture::upload(const Handle handle,
 
         glTexImage2D(GL_TEXTURE_2D, 0, components, size.x, size.y, 0, components, GL_UNSIGNED_BYTE, buffer);
     } else if (format == Etc1 || format == Pvrtc) {
-        const size_t bufferSize = size.x * size.y / 2;
+        const size_t bufferSize = dataSize(format, size);
         const auto components =
             (format == Etc1)
                 ? GL_ETC1_RGB8_OES
@@ -20,9 +20,12 @@ struct Texture {
     uint32_t* sprites;
     size_t spriteCount;
 
+    // GL handle is created on the main thread by the first upload
     Texture(uint32_t* const sprites, const size_t spriteCount);
 
+    static Handle createHandle();
     static void bind(const Handle handle);
+    static size_t dataSize(const Format format, const Vector2D<size_t>& size);
     static void upload(const Handle handle,
                        const uint8_t* const buffer,
                        const Format format,
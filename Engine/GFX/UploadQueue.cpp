@@ -0,0 +1,58 @@
+#include "UploadQueue.hpp"
+
+#include <thread>
+
+#include "Core/Profiler.hpp"
+
+UploadQueue* UploadQueue::DefaultInstance::defaultInstance;
+
+UploadQueue::DefaultInstance::~DefaultInstance() {
+    assert(("Default instance already destroyed", defaultInstance));
+    defaultInstance->~UploadQueue();
+    defaultInstance = nullptr;
+}
+
+UploadQueue& UploadQueue::getDefault() {
+    return *DefaultInstance::defaultInstance;
+}
+
+void UploadQueue::post(const Command& command) {
+    assert(("Nothing to upload", command.texture && command.buffer));
+
+    // main thread drains the queue every frame, wait for it instead of failing
+    const bool owner = SDL_ThreadID() == _owner;
+    while (!_commands.tryPush(command)) {
+        if (owner)
+            process(0, 1);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void UploadQueue::process(const size_t byteBudget, const size_t maxCount) {
+    assert(("Upload queue processed by a thread that doesn't own it", SDL_ThreadID() == _owner));
+    PROFILE_ZONE("UploadQueue::process");
+    size_t uploadedBytes = 0;
+
+    for (size_t i = 0; i < maxCount; ++i) {
+        if (!_hasPending && !_commands.tryPop(_pending))
+            return;
+
+        const size_t size = Texture::dataSize(_pending.format, _pending.size);
+        _hasPending = i > 0 && uploadedBytes + size > byteBudget;
+        if (_hasPending)
+            return;
+
+        Texture* const texture = _pending.texture;
+        if (!texture->handle)
+            texture->handle = Texture::createHandle();
+
+        Texture::upload(texture->handle, _pending.buffer, _pending.format, _pending.size);
+        uploadedBytes += size;
+
+        // completion may post from this thread and reuse the pending slot
+        Job completion = _pending.completion;
+        if (!completion.empty())
+            completion.run();
+    }
+}
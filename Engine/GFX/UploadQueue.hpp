@@ -0,0 +1,81 @@
+#ifndef UploadQueue_h__
+#define UploadQueue_h__
+
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "SDL_thread.h"
+
+#include "Core/Concurrency/Job.hpp"
+#include "Core/Concurrency/MPMCQueue.hpp"
+#include "Geom/Vector2D.hpp"
+#include "GFX/Texture.hpp"
+#include "Util/noncopyable.hpp"
+
+// Marshals texture uploads from loader jobs to the thread that owns GL context
+//
+// Any thread can post an upload of a decoded buffer, the main loop processes
+// a bounded amount of them every frame. Completion job of the command runs on the
+// main thread right after the upload, so it can release the buffer and publish the texture.
+//
+// The queue is owned by the thread that created it, only that thread may process it.
+// When the queue is full, post on the owner thread uploads the oldest command itself
+// instead of waiting for a frame that would never come
+class UploadQueue : public util::Noncopyable {
+public:
+    struct Command {
+        Texture* texture;
+        const uint8_t* buffer;
+        Texture::Format format;
+        Vector2D<size_t> size;
+        Job completion;
+    };
+
+private:
+    static const size_t MaxCommandCount = 64;
+
+    MPMCQueue<Command> _commands;
+
+    // thread which processes the queue, it can't wait for itself to drain it
+    const SDL_threadID _owner;
+
+    // command that did not fit into the previous frame budget
+    Command _pending;
+    bool _hasPending;
+
+public:
+    struct DefaultInstance {
+        static UploadQueue* defaultInstance;
+
+        template <typename Allocator>
+        DefaultInstance(Allocator& alloc) {
+            assert(("Trying to initialize default instance twice", !defaultInstance));
+            void* const memory =
+                alloc.allocate(sizeof(UploadQueue), std::alignment_of<UploadQueue>::value, 0);
+            defaultInstance = new (memory) UploadQueue(alloc);
+        }
+        ~DefaultInstance();
+    };
+
+    static UploadQueue& getDefault();
+
+    template <typename Allocator>
+    explicit UploadQueue(Allocator& alloc) :
+        _commands {alloc, MaxCommandCount},
+        _owner {SDL_ThreadID()},
+        _pending(),
+        _hasPending {false}
+    {}
+
+    // Can be called from any thread. Waits while the queue is full,
+    // except on the owner thread which uploads the oldest command itself to make room
+    void post(const Command& command);
+
+    // Owner thread only. Uploads at most maxCount commands, stopping once byteBudget is spent.
+    // The first command is always uploaded, so big textures can't get stuck
+    void process(const size_t byteBudget, const size_t maxCount);
+};
+
+#endif // UploadQueue_h__
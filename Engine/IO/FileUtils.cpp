@@ -4,8 +4,10 @@
 #include "Core/Memory/SmallObjectPool.hpp"
 
 #include "SDL_filesystem.h"
+#include "SDL_log.h"
 
 #include <cassert>
+#include <cstring>
 #include <memory>
 
 #ifdef __WIN32__
@@ -49,12 +51,47 @@ String FileUtils::writablePath() {
 #endif //__WIN32__
 }
 
+struct DataDirectory {
+    static const size_t MaxSize = 1024;
+
+    char path[MaxSize];
+    size_t length;
+
+    DataDirectory() :
+        length{ 0 }
+    {
+        std::unique_ptr<char, decltype(&SDL_free)> base{ SDL_GetBasePath(), &SDL_free };
+        const size_t baseLength = base ? strlen(base.get()) : 0;
+
+        assert(("Data directory path is too long", baseLength + sizeof(DATA_PATH) <= MaxSize));
+        if (baseLength + sizeof(DATA_PATH) > MaxSize) {
+            SDL_Log("Data directory path is too long, data is looked up in the working directory");
+            memcpy(path, DATA_PATH, sizeof(DATA_PATH));
+            length = sizeof(DATA_PATH) - 1;
+            return;
+        }
+
+        memcpy(path, base.get(), baseLength);
+        memcpy(path + baseLength, DATA_PATH, sizeof(DATA_PATH));
+        length = baseLength + sizeof(DATA_PATH) - 1;
+    }
+};
+
+// Built on first use and kept until exit, base path doesn't change while the app runs.
+// Lives in static storage, so it doesn't depend on engine allocators being alive
+static const DataDirectory& dataDirectory() {
+    static const DataDirectory directory;
+    return directory;
+}
+
 String FileUtils::dataPath(const char* const fileName) {
-    return basePath() + DATA_PATH + fileName;
+    const DataDirectory& directory = dataDirectory();
+    return String::join(directory.path, directory.length, fileName, strlen(fileName));
 }
 
 String FileUtils::dataPath(const String& fileName) {
-    return basePath() + DATA_PATH + fileName;
+    const DataDirectory& directory = dataDirectory();
+    return String::join(directory.path, directory.length, fileName.begin(), fileName.size());
 }
 
 String FileUtils::writableDataPath(const char* const fileName) {
@@ -2,14 +2,19 @@
 
 #include <type_traits>
 
+#include "SDL_log.h"
+
 #include "Core/Concurrency/Job.hpp"
 #include "Core/Concurrency/JobQueue.hpp"
 #include "Core/Memory/DoubleEndedLinearAllocator.hpp"
-#include "Core/Memory/SmallObjectPool.hpp"
+#include "Core/Memory/MemoryTelemetry.hpp"
+#include "Core/Memory/TlsfAllocator.hpp"
+#include "Core/Profiler.hpp"
 #include "Core/SpriteRegistry.hpp"
 #include "Core/TextureRegistry.hpp"
 #include "GFX/Sprite.hpp"
 #include "GFX/Texture.hpp"
+#include "GFX/UploadQueue.hpp"
 #include "Geom/Rect.hpp"
 #include "Geom/Vector2D.hpp"
 #include "IO/Stream.hpp"
@@ -24,6 +29,10 @@ static const size_t textureAlignment = sizeof(Texture);
 static const size_t spriteSize = sizeof(Sprite);
 static const size_t spriteAlignment = sizeof(Sprite);
 
+// Atlases are decoded on several workers at once, so every job
+// takes its temporaries from an arena of its own
+static const size_t temporariesReserveSize = 32 * 1024 * 1024;
+
 static void loadBlobPart(Stream& stream,
                          const Sprite* const image,
                          uint8_t* const buffer,
@@ -53,7 +62,7 @@ static void loadBlob(Stream& stream,
 
 static Sprite* loadSprite(Stream& stream,
                           const uint32_t texture,
-                          DoubleEndedLinearAllocator& alloc) {
+                          Sprite* const memory) {
     const size_t left = stream.readShortLE();
     const size_t top = stream.readShortLE();
     const size_t width = stream.readShortLE();
@@ -68,77 +77,89 @@ static Sprite* loadSprite(Stream& stream,
     const Vector2D<uint16_t> textureOffset(left, top);
     const Vector2D<uint16_t> size(left + width, top + height);
     const Vector2D<uint16_t> coordinateOffset(dx, dy);
-    auto imageMemory = alloc.allocate(spriteSize, spriteAlignment, 0);
-    return new (imageMemory) Sprite(texture, textureOffset, size, coordinateOffset);
+    return new (memory) Sprite(texture, textureOffset, size, coordinateOffset);
 }
 
 static void loadSprites(Stream& stream,
                         Sprite** const images,
+                        Sprite* const sprites,
                         const uint32_t* const spriteHashes,
                         const size_t spriteCount,
-                        const uint32_t texture,
-                        DoubleEndedLinearAllocator &alloc) {
+                        const uint32_t texture) {
     for (size_t i = 0; i < spriteCount; ++i) {
-        auto rewindPoint = alloc.rewindMarkerBack();
-        images[i] = loadSprite(stream, texture, alloc);
-        alloc.rewindBack(rewindPoint);
-
-        SpriteRegistry::getDefault().registerResource(spriteHashes[i], images[i]);
+        images[i] = loadSprite(stream, texture, &sprites[i]);
     }
+
+    PROFILE_ZONE("Register sprites");
+    SpriteRegistry::getDefault().registerResources(spriteHashes, images, spriteCount);
 }
 
-static uint8_t* readImageData(Stream& stream,
-                              const uint32_t nameHash,
-                              const uint32_t* const spriteHashes,
-                              const size_t spriteCount,
-                              const Vector2D<size_t>& size,
-                              const Texture::Format format,
-                              DoubleEndedLinearAllocator& alloc) {
+static void readImageData(Stream& stream,
+                          const uint32_t nameHash,
+                          const uint32_t* const spriteHashes,
+                          Sprite* const sprites,
+                          const size_t spriteCount,
+                          uint8_t* const buffer,
+                          const Vector2D<size_t>& size,
+                          const Texture::Format format,
+                          DoubleEndedLinearAllocator& alloc) {
     const bool isBlob = format == Texture::Uncompressed;
-    const bool needAlpha = (format & Texture::Alpha) == Texture::Alpha;
 
-    uint8_t* buffer = nullptr;
-    if (isBlob) {
-        buffer = static_cast<uint8_t*>(alloc.allocateBack(4 * size.x * size.y, 4, 0));
-    } else {
+    if (!isBlob) {
         assert((format & Texture::Etc1) || (format & Texture::Pvrtc));
-        const size_t textureSize = size.x * size.y / 2;
-        const size_t bufferSize = needAlpha ? textureSize * 2 : textureSize;
-
-        buffer = static_cast<uint8_t*>(alloc.allocateBack(bufferSize, 4, 0));
-
-        stream.readTo(buffer, textureSize);
+        stream.readTo(buffer, Texture::dataSize(format, size));
     }
 
     auto images = static_cast<Sprite**>(alloca(spriteCount * sizeof(Sprite*)));
-    loadSprites(stream, images, spriteHashes, spriteCount, nameHash, alloc);
+    loadSprites(stream, images, sprites, spriteHashes, spriteCount, nameHash);
 
     if (isBlob) {
         loadBlob(stream, images, buffer, size, spriteCount, alloc);
     }
+}
 
-    return buffer;
+// Decode buffers live until the upload is done, so they go to the heap instead of the job arena.
+// Returns nullptr if the heap is full
+static uint8_t* allocateDecodeBuffer(const Texture::Format format, const Vector2D<size_t>& size) {
+    return static_cast<uint8_t*>(TlsfAllocator::getDefault().allocate(Texture::dataSize(format, size), 4, 0));
 }
 
-static void readImageAlpha(Stream& stream, uint8_t* buffer, DoubleEndedLinearAllocator& alloc) {
-    loadPng(stream, buffer, alloc);
+// Runs on the main thread once the texture is uploaded
+static void finishLoading(const uint32_t hash,
+                          Texture* const texture,
+                          uint8_t* const buffer,
+                          uint8_t* const alphaBuffer) {
+    // decode buffers are not needed anymore
+    TlsfAllocator::getDefault().free(buffer);
+    if (alphaBuffer)
+        TlsfAllocator::getDefault().free(alphaBuffer);
+
+    TextureRegistry::getDefault().registerResource(hash, texture);
 }
 
-static Texture* load(const uint32_t nameHash,
-                     const char* const path,
-                     DoubleEndedLinearAllocator& alloc) {
-    Stream stream = Stream::fromFile(path, "rb");
+static void postUpload(Texture* const texture,
+                       const uint8_t* const buffer,
+                       const Texture::Format format,
+                       const Vector2D<size_t>& size,
+                       const Job& completion) {
+    const UploadQueue::Command command = {texture, buffer, format, size, completion};
+    UploadQueue::getDefault().post(command);
+}
 
-    const size_t spriteCount = stream.readShortLE();
-    const size_t spriteHashesBufferSize = hashSize * spriteCount;
-    auto spriteHashes =
-        static_cast<uint8_t*>(alloc.allocate(spriteHashesBufferSize, hashAlignment, 0));
+// Reads and decodes atlas on a worker thread, GL upload is posted to the main thread
+static void load(const uint32_t hash,
+                 const char* const path,
+                 Texture* const texture,
+                 Sprite* const sprites) {
+    MEMORY_TAG("Atlas");
 
-    stream.readTo(spriteHashes, spriteHashesBufferSize);
+    DoubleEndedLinearAllocator alloc(temporariesReserveSize, VirtualMemory::NormalPages, "Atlas temporaries");
 
-    auto textureMemory = alloc.allocate(textureSize, textureAlignment, 0);
-    auto texture =
-        new (textureMemory) Texture(reinterpret_cast<uint32_t*>(spriteHashes), spriteCount);
+    Stream stream = Stream::fromFile(path, "rb");
+
+    // sprite hashes were read by loadAtlas already
+    const size_t spriteCount = texture->spriteCount;
+    stream.seek(sizeof(uint16_t) + hashSize * spriteCount);
 
     const size_t width = stream.readShortLE();
     const size_t height = stream.readShortLE();
@@ -146,59 +167,60 @@ static Texture* load(const uint32_t nameHash,
     const Vector2D<size_t> size(width, height);
 
     const auto format = static_cast<Texture::Format>(stream.readByte());
-    uint8_t* const buffer =
-        readImageData(stream, nameHash, texture->sprites, spriteCount, size, format, alloc);
+    const auto colorFormat = static_cast<Texture::Format>(format & ~Texture::Alpha);
+    const bool needAlpha = (format & Texture::Alpha) == Texture::Alpha;
 
-    Texture::upload(texture->handle, buffer, format, size);
+    // both buffers are taken before sprites are registered, so an atlas that doesn't fit is skipped whole
+    uint8_t* const buffer = allocateDecodeBuffer(colorFormat, size);
+    if (!buffer) {
+        SDL_Log("Not enough memory to decode atlas %s", path);
+        return;
+    }
 
-    const bool needAlpha = (format & Texture::Alpha) == Texture::Alpha;
-    if (needAlpha) {
-        readImageAlpha(stream, buffer, alloc);
-        Texture::upload(texture->handle, buffer, Texture::Alpha, size);
+    uint8_t* const alphaBuffer = needAlpha ? allocateDecodeBuffer(Texture::Alpha, size) : nullptr;
+    if (needAlpha && !alphaBuffer) {
+        SDL_Log("Not enough memory to decode alpha of atlas %s", path);
+        TlsfAllocator::getDefault().free(buffer);
+        return;
     }
 
-    return texture;
-}
+    readImageData(stream, hash, texture->sprites, sprites, spriteCount, buffer, size, colorFormat, alloc);
+    if (needAlpha)
+        loadPng(stream, alphaBuffer, alloc);
 
-struct Context {
-    const uint32_t hash;
-    const char* const path;
-    DoubleEndedLinearAllocator& alloc;
-
-    Context(const uint32_t hash, const char* const path, DoubleEndedLinearAllocator& alloc) :
-        hash {hash},
-        path {path},
-        alloc(alloc)
-    {}
-};
-
-static const size_t ContextSize = sizeof(Context);
-static const size_t ContextAlignment = std::alignment_of<Context>::value;
-
-static Context* setupContext(const uint32_t hash,
-                             const char* const path,
-                             DoubleEndedLinearAllocator& alloc) {
-    void* memory =
-        SmallObjectPool::getDefault().allocate(ContextSize, ContextAlignment, 0);
-    return new (memory) Context(hash, path, alloc);
-}
+    const Job completion = Job::create([hash, texture, buffer, alphaBuffer]() {
+        finishLoading(hash, texture, buffer, alphaBuffer);
+    });
 
-void releaseContext(const Context* const context) {
-    SmallObjectPool::getDefault().free(const_cast<Context* const>(context));
+    postUpload(texture, buffer, colorFormat, size, needAlpha ? Job() : completion);
+    if (needAlpha)
+        postUpload(texture, alphaBuffer, Texture::Alpha, size, completion);
 }
 
 void Loader::loadAtlas(const uint32_t hash,
                        const char* const path,
                        DoubleEndedLinearAllocator& alloc) {
-    JobQueue::getDefault().add(Job([](void* payload) {
-        const auto context = static_cast<Context*>(payload);
+    MEMORY_TAG("Atlas");
+
+    // texture and sprites live as long as the pack, so they come from the pack allocator
+    // on the calling thread, the job never touches it
+    Stream stream = Stream::fromFile(path, "rb");
 
-        auto rewindPoint = context->alloc.rewindMarkerBack();
-        auto texture = load(context->hash, context->path, context->alloc);
-        context->alloc.rewindBack(rewindPoint);
+    const size_t spriteCount = stream.readShortLE();
+    const size_t spriteHashesBufferSize = hashSize * spriteCount;
+    auto spriteHashes =
+        static_cast<uint8_t*>(alloc.allocate(spriteHashesBufferSize, hashAlignment, 0));
+
+    stream.readTo(spriteHashes, spriteHashesBufferSize);
+
+    auto textureMemory = alloc.allocate(textureSize, textureAlignment, 0);
+    auto texture =
+        new (textureMemory) Texture(reinterpret_cast<uint32_t*>(spriteHashes), spriteCount);
 
-        TextureRegistry::getDefault().registerResource(context->hash, texture);
+    auto sprites =
+        static_cast<Sprite*>(alloc.allocate(spriteSize * spriteCount, spriteAlignment, 0));
 
-        releaseContext(context);
-    }, setupContext(hash, path, alloc)));
+    JobQueue::getDefault().add(Job::create([hash, path, texture, sprites]() {
+        load(hash, path, texture, sprites);
+    }), JobQueue::Background);
 }
@@ -3,6 +3,9 @@
 #include <algorithm>
 #include <cassert>
 
+#include "SDL_log.h"
+
+#include "Core/Name.hpp"
 #include "Core/Memory/DoubleEndedLinearAllocator.hpp"
 #include "Loaders/LoadAtlas.hpp"
 #include "Loaders/LoadAnimation.hpp"
@@ -61,9 +64,17 @@ static uint32_t* loadResourceSectionVersion0(const size_t sectionIndex,
 
         stream.readTo(path, pathSize);
 
-        loader.load(hash, reinterpret_cast<char* const>(path), alloc);
-
+        // loaders finish in jobs after the path buffer is reused, interned copy lives long enough.
+        // Paths are not null terminated in the pack, a shorter one leaves the tail of the previous
+        const Name name(reinterpret_cast<char*>(path), pathSize);
         hashes[i] = hash;
+
+        if (pathSize && name.empty()) {
+            SDL_Log("Skipping resource %.*s, its path can't be stored",
+                    static_cast<int>(pathSize), reinterpret_cast<char*>(path));
+            continue;
+        }
+        loader.load(hash, name.c_str(), alloc);
     }
     return hashes;
 }
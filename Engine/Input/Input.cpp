@@ -2,7 +2,7 @@
 
 #include "SDL_events.h"
 
-#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScratchAllocator.hpp"
 #include "Core/Memory/ScopeStack.hpp"
 #include "GFX/Window.hpp"
 
@@ -66,7 +66,8 @@ void Input::processEvents(const Window* window) NOEXCEPT {
     assert(window);
 
     uint8_t scratchBuffer[ScratchBufferSize];
-    LinearAllocator scratch(std::begin(scratchBuffer), std::end(scratchBuffer));
+    ScratchAllocator scratch(std::begin(scratchBuffer), std::end(scratchBuffer),
+                             ScratchBlockPool::getDefault(), "Input scratch");
 
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
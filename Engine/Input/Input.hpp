@@ -6,7 +6,7 @@
 #include "Core/Event.hpp"
 #include "Util/noncopyable.hpp"
 
-class LinearAllocator;
+class ScratchAllocator;
 template <typename Allocator>
 class ScopeStack;
 
@@ -17,7 +17,7 @@ struct SDL_MouseMotionEvent;
 struct SDL_TouchFingerEvent;
 
 class Input : public util::Noncopyable {
-    typedef ScopeStack<LinearAllocator> ScopeAlloc;
+    typedef ScopeStack<ScratchAllocator> ScopeAlloc;
 
     void handleExitRequest(ScopeAlloc& scratch) const NOEXCEPT;
     void handleKeyPress(ScopeAlloc& scratch,
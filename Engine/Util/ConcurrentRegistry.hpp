@@ -0,0 +1,152 @@
+#ifndef ConcurrentRegistry_h__
+#define ConcurrentRegistry_h__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+#include "Registry.hpp"
+#include "defines.hpp"
+#include "noncopyable.hpp"
+
+namespace util {
+
+// Registry which can be read from any thread while other threads register resources.
+//
+// Keeps two copies of the table, readers use the published one and writers change
+// the other one (left-right scheme):
+//   1. wait for readers still inside the hidden copy to leave, change it
+//   2. publish it, new readers go there
+//   3. wait for readers of the previously published copy to leave, change it the same way
+//
+// Readers never lock or wait, they announce themselves in a counter of the copy they use
+// and check that it is still published. Writers are serialized with a spinlock and wait
+// only for readers, whose lookups are short
+template <typename T, size_t Size>
+class ConcurrentRegistry : public util::Noncopyable {
+    typedef Registry<T, Size> Table;
+
+    static const size_t CacheLineSize = 64;
+
+    Table _tables[2];
+
+    std::atomic<size_t> _published;
+    std::atomic_flag _writeLock;
+    uint8_t _pad0[CacheLineSize - sizeof(std::atomic<size_t>) - sizeof(std::atomic_flag)];
+
+    // readers of different copies live on separate cache lines
+    mutable std::atomic<size_t> _readers0;
+    uint8_t _pad1[CacheLineSize - sizeof(std::atomic<size_t>)];
+
+    mutable std::atomic<size_t> _readers1;
+    uint8_t _pad2[CacheLineSize - sizeof(std::atomic<size_t>)];
+
+    REALLY_INLINE std::atomic<size_t>& readers(const size_t table) const NOEXCEPT {
+        return table ? _readers1 : _readers0;
+    }
+
+    void waitForReaders(const size_t table) NOEXCEPT {
+        while (readers(table).load(std::memory_order_seq_cst))
+            std::this_thread::yield();
+    }
+
+    // Applies the change to both copies, readers see it at once when the hidden copy is published
+    template <typename Change>
+    void write(const Change& change) NOEXCEPT {
+        while (_writeLock.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+
+        const size_t published = _published.load(std::memory_order_relaxed);
+        const size_t hidden = published ^ 1;
+
+        waitForReaders(hidden);
+        change(_tables[hidden]);
+        _published.store(hidden, std::memory_order_seq_cst);
+
+        waitForReaders(published);
+        change(_tables[published]);
+
+        _writeLock.clear(std::memory_order_release);
+    }
+
+public:
+    struct DefaultInstance {
+        static ConcurrentRegistry* defaultInstance;
+
+        template <typename Allocator>
+        DefaultInstance(Allocator& alloc) {
+            assert(("Trying to initialize default instance twice", !defaultInstance));
+            void* const memory =
+                alloc.allocate(sizeof(ConcurrentRegistry), std::alignment_of<ConcurrentRegistry>::value, 0);
+            defaultInstance = new (memory) ConcurrentRegistry(alloc);
+        }
+
+        ~DefaultInstance() {
+            assert(("Default instance already destroyed", defaultInstance));
+            defaultInstance->~ConcurrentRegistry();
+            defaultInstance = nullptr;
+        }
+    };
+
+    static ConcurrentRegistry& getDefault() {
+        return *DefaultInstance::defaultInstance;
+    }
+
+    template <typename Allocator>
+    ConcurrentRegistry(Allocator& alloc) NOEXCEPT :
+        _tables {{alloc}, {alloc}},
+        _published {0},
+        _readers0 {0},
+        _readers1 {0}
+    {
+        _writeLock.clear();
+    }
+
+    void registerResource(const uint32_t nameHash, const T* resource) NOEXCEPT {
+        write([nameHash, resource](Table& table) {
+            table.registerResource(nameHash, resource);
+        });
+    }
+
+    void registerResources(const uint32_t* const nameHashes,
+                           const T* const* const resources,
+                           const size_t count) NOEXCEPT {
+        write([nameHashes, resources, count](Table& table) {
+            table.registerResources(nameHashes, resources, count);
+        });
+    }
+
+    void unregisterResource(const uint32_t nameHash) NOEXCEPT {
+        write([nameHash](Table& table) {
+            table.unregisterResource(nameHash);
+        });
+    }
+
+    const T* resourceForHandle(const uint32_t nameHash) const NOEXCEPT {
+        size_t table = _published.load(std::memory_order_seq_cst);
+        for (;;) {
+            readers(table).fetch_add(1, std::memory_order_seq_cst);
+
+            // writer may have switched tables before seeing this reader, it may be changing this one now
+            const size_t published = _published.load(std::memory_order_seq_cst);
+            if (published == table)
+                break;
+
+            readers(table).fetch_sub(1, std::memory_order_release);
+            table = published;
+        }
+
+        const T* const resource = _tables[table].resourceForHandle(nameHash);
+        readers(table).fetch_sub(1, std::memory_order_release);
+        return resource;
+    }
+};
+
+template <typename T, size_t Size>
+ConcurrentRegistry<T, Size>* ConcurrentRegistry<T, Size>::DefaultInstance::defaultInstance;
+
+}
+
+#endif // ConcurrentRegistry_h__
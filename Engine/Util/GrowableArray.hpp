@@ -0,0 +1,191 @@
+#ifndef GrowableArray_h__
+#define GrowableArray_h__
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+#include "Util/type_traits.hpp"
+
+namespace util {
+
+// Array without a hard capacity, grows by reallocating from the allocator it was created with.
+//
+// Capacity doubles on every reallocation. Old buffer is freed if the allocator can free,
+// with arenas it stays until the arena is rewound, so all buffers together take less
+// than twice the final capacity. Reserve up front when the size is known
+template <typename T, typename Allocator>
+class GrowableArray : public util::Noncopyable {
+    Allocator* _alloc;
+    T* _ptr;
+    size_t _capacity;
+    size_t _size;
+
+    static const size_t elementSize = sizeof(T);
+    static const size_t alignment = std::alignment_of<T>::value;
+
+    static const size_t MinCapacity = 4;
+
+    static void release(Allocator& alloc, T* const data, std::true_type) NOEXCEPT {
+        alloc.free(data);
+    }
+
+    static void release(Allocator&, T* const, std::false_type) NOEXCEPT {
+    }
+
+    void release() NOEXCEPT {
+        if (_ptr)
+            release(*_alloc, _ptr, std::integral_constant<bool, util::HasFree<Allocator>::value>());
+    }
+
+    void destroy(T* const from) {
+        auto to = end();
+        for (auto pos = from; pos != to; ++pos)
+            pos->~T();
+    }
+
+    void grow(const size_t capacity) {
+        auto ptr = static_cast<T*>(_alloc->allocate(elementSize * capacity, alignment, 0));
+
+        for (size_t i = 0; i < _size; ++i) {
+            new (&ptr[i]) T(std::move(_ptr[i]));
+            _ptr[i].~T();
+        }
+
+        release();
+        _ptr = ptr;
+        _capacity = capacity;
+    }
+
+    REALLY_INLINE void ensureCapacity() {
+        if (_size == _capacity)
+            grow(std::max(_capacity * 2, MinCapacity));
+    }
+
+public:
+    explicit GrowableArray(Allocator& alloc, const size_t capacity = 0) :
+        _alloc{ &alloc },
+        _ptr{ nullptr },
+        _capacity{ 0 },
+        _size{ 0 }
+    {
+        if (capacity)
+            grow(capacity);
+    }
+
+    GrowableArray(GrowableArray&& other) :
+        _alloc{ other._alloc },
+        _ptr{ other._ptr },
+        _capacity{ other._capacity },
+        _size{ other._size }
+    {
+        other._ptr = nullptr;
+        other._capacity = 0;
+        other._size = 0;
+    }
+
+    ~GrowableArray() {
+        destroy(begin());
+        release();
+    }
+
+    GrowableArray& operator =(GrowableArray&& other) NOEXCEPT {
+        other.swap(*this);
+
+        return *this;
+    }
+
+    void swap(GrowableArray& other) NOEXCEPT {
+        std::swap(_alloc, other._alloc);
+        std::swap(_ptr, other._ptr);
+        std::swap(_capacity, other._capacity);
+        std::swap(_size, other._size);
+    }
+
+    void reserve(const size_t capacity) {
+        if (capacity > _capacity)
+            grow(capacity);
+    }
+
+    void clear() {
+        destroy(begin());
+        _size = 0;
+    }
+
+    void add(const T& value) {
+        ensureCapacity();
+        new (&_ptr[_size++]) T(value);
+    }
+
+    void add(T&& value) {
+        ensureCapacity();
+        new (&_ptr[_size++]) T(std::move(value));
+    }
+
+    template <typename... Args>
+    T& emplace(Args&& ...args) {
+        ensureCapacity();
+        return *new (&_ptr[_size++]) T(std::forward<Args>(args)...);
+    }
+
+    void pop() {
+        assert(("Trying to pop from an empty array", _size));
+        _ptr[--_size].~T();
+    }
+
+    REALLY_INLINE T& operator[] (const size_t index) NOEXCEPT {
+        assert(("Invalid index", index < _size));
+        return _ptr[index];
+    }
+
+    REALLY_INLINE const T& operator[] (const size_t index) const NOEXCEPT {
+        assert(("Invalid index", index < _size));
+        return _ptr[index];
+    }
+
+    REALLY_INLINE T& back() NOEXCEPT {
+        assert(("Array is empty", _size));
+        return _ptr[_size - 1];
+    }
+
+    REALLY_INLINE T* begin() NOEXCEPT {
+        return _ptr;
+    }
+
+    REALLY_INLINE const T* begin() const NOEXCEPT {
+        return _ptr;
+    }
+
+    REALLY_INLINE T* end() NOEXCEPT {
+        return _ptr + _size;
+    }
+
+    REALLY_INLINE const T* end() const NOEXCEPT {
+        return _ptr + _size;
+    }
+
+    REALLY_INLINE bool empty() const NOEXCEPT {
+        return _size == 0;
+    }
+
+    REALLY_INLINE size_t size() const NOEXCEPT {
+        return _size;
+    }
+
+    REALLY_INLINE size_t capacity() const NOEXCEPT {
+        return _capacity;
+    }
+};
+
+// std::max takes it by reference
+template <typename T, typename Allocator>
+const size_t GrowableArray<T, Allocator>::MinCapacity;
+
+}
+
+#endif // GrowableArray_h__
@@ -5,35 +5,92 @@
 #include <cassert>
 #include <cstdint>
 #include <type_traits>
+#include <utility>
 
 #include "defines.hpp"
 
 namespace util {
 
+constexpr size_t ceilLog2(const size_t value, const size_t log2 = 0) {
+    return (static_cast<size_t>(1) << log2) >= value ? log2 : ceilLog2(value, log2 + 1);
+}
+
+// Maps name hashes to resources with open addressing and Robin Hood probing.
+//
+// Entry which is farther from its home slot takes the place of a closer one on insertion,
+// so probe sequences stay short and lookup of a missing name stops as soon as it meets
+// an entry closer to home than the probe. Removal shifts the following entries back
+// instead of leaving tombstones
 template <typename T, size_t Size>
 class Registry {
     struct Entry {
         uint32_t nameHash;
-        const T* resource;
 
-        bool operator <(const Entry& other) const {
-            return nameHash < other.nameHash;
-        }
+        // Null for empty slots
+        const T* resource;
     };
 
     static const size_t MaxResourceCount = Size;
-    static const size_t EntryStorageSize = MaxResourceCount * sizeof(Entry);
+
+    // Table is kept at most 7/8 full
+    static const size_t TableSizeLog2 = ceilLog2(MaxResourceCount + MaxResourceCount / 7 + 1);
+    static const size_t TableSize = static_cast<size_t>(1) << TableSizeLog2;
+    static const size_t TableMask = TableSize - 1;
+    static_assert(TableSizeLog2 <= 32, "Registry is too big");
+
+    static const size_t EntryStorageSize = TableSize * sizeof(Entry);
     static const size_t EntryAlignment = std::alignment_of<Entry>::value;
 
     Entry* const _entries;
     size_t _entryCount;
 
+    // Name hashes may have poor low bits, Fibonacci hashing spreads them over the table
+    REALLY_INLINE static size_t homeSlot(const uint32_t nameHash) NOEXCEPT {
+        return static_cast<uint32_t>(nameHash * 2654435769u) >> (32 - TableSizeLog2);
+    }
+
+    REALLY_INLINE static size_t probeDistance(const size_t slot, const uint32_t nameHash) NOEXCEPT {
+        return (slot - homeSlot(nameHash)) & TableMask;
+    }
+
+    // Returns nullptr if there is no such entry
     Entry* entryForHash(const uint32_t nameHash) const NOEXCEPT {
-        Entry* const begin = _entries;
-        Entry* const end = _entries + _entryCount;
+        size_t slot = homeSlot(nameHash);
+        for (size_t distance = 0; ; ++distance) {
+            Entry* const entry = _entries + slot;
+            if (!entry->resource || probeDistance(slot, entry->nameHash) < distance)
+                return nullptr;
+
+            if (entry->nameHash == nameHash)
+                return entry;
 
-        const Entry value = {nameHash, nullptr};
-        return std::lower_bound(begin, end, value);
+            slot = (slot + 1) & TableMask;
+        }
+    }
+
+    void insert(const uint32_t nameHash, const T* const resource) NOEXCEPT {
+        assert(("No resource", resource));
+
+        Entry value = {nameHash, resource};
+        size_t slot = homeSlot(nameHash);
+        for (size_t distance = 0; ; ++distance) {
+            Entry& entry = _entries[slot];
+            if (!entry.resource) {
+                entry = value;
+                return;
+            }
+
+            // displaced entries are never equal to the rest, so only the new one can collide
+            assert(("Resource name collision", entry.nameHash != value.nameHash));
+
+            const size_t entryDistance = probeDistance(slot, entry.nameHash);
+            if (entryDistance < distance) {
+                std::swap(entry, value);
+                distance = entryDistance;
+            }
+
+            slot = (slot + 1) & TableMask;
+        }
     }
 
 public:
@@ -63,38 +120,61 @@ public:
     Registry(Allocator& alloc) NOEXCEPT :
         _entries {static_cast<Entry*>(alloc.allocate(EntryStorageSize, EntryAlignment, 0))},
         _entryCount {0}
-    {}
+    {
+        const Entry empty = {0, nullptr};
+        std::fill_n(_entries, TableSize, empty);
+    }
 
     void registerResource(const uint32_t nameHash, const T* resource) NOEXCEPT {
-        assert(("No resource", resource));
         assert(("Maximum resource count reached", _entryCount < MaxResourceCount));
 
-        auto pos = entryForHash(nameHash);
-        assert(("Resource name collision", pos == _entries + _entryCount || pos->nameHash != nameHash));
-
-        auto end = _entries + _entryCount;
-        std::rotate(pos, end, end + 1);
+        insert(nameHash, resource);
+        ++_entryCount;
+    }
 
-        const Entry value = {nameHash, resource};
-        *pos = value;
+    // Names must differ from each other and from names already registered
+    void registerResources(const uint32_t* const nameHashes,
+                           const T* const* const resources,
+                           const size_t count) NOEXCEPT {
+        assert(("Maximum resource count reached", _entryCount + count <= MaxResourceCount));
 
-        ++_entryCount;
+        for (size_t i = 0; i < count; ++i)
+            insert(nameHashes[i], resources[i]);
+        _entryCount += count;
     }
 
     void unregisterResource(const uint32_t nameHash) NOEXCEPT {
         auto pos = entryForHash(nameHash);
-        assert(("No resource found", pos != _entries + _entryCount));
+        assert(("No resource found", pos));
+
+        // entries after the removed one move a slot closer to home until one is already there
+        size_t slot = pos - _entries;
+        for (;;) {
+            const size_t next = (slot + 1) & TableMask;
+            const Entry& entry = _entries[next];
+            if (!entry.resource || probeDistance(next, entry.nameHash) == 0)
+                break;
+
+            _entries[slot] = entry;
+            slot = next;
+        }
 
-        std::rotate(pos, pos + 1, _entries + _entryCount);
+        _entries[slot].resource = nullptr;
         --_entryCount;
     }
 
     const T* resourceForHandle(const uint32_t nameHash) const NOEXCEPT {
         auto entry = entryForHash(nameHash);
-        assert(("No resource found", entry != _entries + _entryCount));
+        assert(("No resource found", entry));
 
         return entry->resource;
     }
+
+    // Returns nullptr if there is no such resource
+    const T* findResource(const uint32_t nameHash) const NOEXCEPT {
+        auto entry = entryForHash(nameHash);
+        return entry ? entry->resource : nullptr;
+    }
 };
 
 template <typename T, size_t Size>
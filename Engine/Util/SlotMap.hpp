@@ -0,0 +1,205 @@
+#ifndef SlotMap_h__
+#define SlotMap_h__
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Util/defines.hpp"
+#include "Util/noncopyable.hpp"
+
+namespace util {
+
+// Handle stays the same while the item lives, cycle tells apart items reusing the same slot
+struct SlotHandle {
+    uint32_t index : 24;
+    uint32_t cycle : 8;
+};
+
+inline bool operator ==(const SlotHandle a, const SlotHandle b) NOEXCEPT {
+    return a.index == b.index && a.cycle == b.cycle;
+}
+
+inline bool operator !=(const SlotHandle a, const SlotHandle b) NOEXCEPT {
+    return !(a == b);
+}
+
+// Items are stored densely and can be iterated as an array, handles refer
+// to them through a lookup table so items can move without invalidating handles
+//
+// [iiiiiiiii......]  items, removing an item moves the last one into its place
+//           ^
+//           --size
+//
+// Every item knows its slot in the lookup table, slot knows the item index and the cycle.
+// Unused slots store the index of the next free slot
+template <typename T>
+class SlotMap : public util::Noncopyable {
+public:
+    typedef SlotHandle Handle;
+
+    static const size_t MaxCapacity = 1 << 24;
+
+private:
+    T* const _items;
+    uint32_t* const _slots;
+    Handle* const _lookup;
+    const size_t _capacity;
+    size_t _size;
+    uint32_t _firstFreeSlot;
+
+    static const size_t ItemAlignment = std::alignment_of<T>::value;
+    static const size_t SlotAlignment = std::alignment_of<uint32_t>::value;
+    static const size_t LookupAlignment = std::alignment_of<Handle>::value;
+
+    REALLY_INLINE void place(const size_t index, const uint32_t slot) NOEXCEPT {
+        _slots[index] = slot;
+        _lookup[slot].index = static_cast<uint32_t>(index);
+    }
+
+public:
+    template <typename Allocator>
+    SlotMap(Allocator& alloc, const size_t capacity) :
+        _items {static_cast<T*>(alloc.allocate(sizeof(T) * capacity, ItemAlignment, 0))},
+        _slots {static_cast<uint32_t*>(alloc.allocate(sizeof(uint32_t) * capacity, SlotAlignment, 0))},
+        _lookup {static_cast<Handle*>(alloc.allocate(sizeof(Handle) * capacity, LookupAlignment, 0))},
+        _capacity {capacity},
+        _size {0},
+        _firstFreeSlot {0}
+    {
+        assert(("Slot map capacity is too big", capacity <= MaxCapacity));
+
+        // initialize lookup table with indices of the next free slot
+        for (size_t i = 0; i < capacity; ++i)
+            _lookup[i] = {static_cast<uint32_t>(i + 1), 0};
+    }
+
+    ~SlotMap() {
+        clear();
+    }
+
+    template <typename... Args>
+    Handle insert(Args&& ...args) {
+        assert(("Slot map is full", _size < _capacity));
+
+        const uint32_t slot = _firstFreeSlot;
+        _firstFreeSlot = _lookup[slot].index;
+
+        new (&_items[_size]) T(std::forward<Args>(args)...);
+        place(_size, slot);
+        ++_size;
+
+        return {slot, _lookup[slot].cycle};
+    }
+
+    void erase(const Handle handle) {
+        assert(("Using handle of removed item", contains(handle)));
+
+        const size_t index = _lookup[handle.index].index;
+        const size_t last = _size - 1;
+        if (index != last) {
+            _items[index] = std::move(_items[last]);
+            place(index, _slots[last]);
+        }
+        _items[last].~T();
+        --_size;
+
+        // bumping the cycle invalidates handles of the removed item
+        _lookup[handle.index] = {_firstFreeSlot, static_cast<uint32_t>(handle.cycle + 1)};
+        _firstFreeSlot = handle.index;
+    }
+
+    void clear() {
+        while (_size)
+            erase(handleAt(_size - 1));
+    }
+
+    REALLY_INLINE bool contains(const Handle handle) const NOEXCEPT {
+        return handle.index < _capacity && _lookup[handle.index].cycle == handle.cycle
+            && _lookup[handle.index].index < _size && _slots[_lookup[handle.index].index] == handle.index;
+    }
+
+    // Returns nullptr if the item was removed
+    REALLY_INLINE T* find(const Handle handle) NOEXCEPT {
+        return contains(handle) ? &_items[_lookup[handle.index].index] : nullptr;
+    }
+
+    REALLY_INLINE T& get(const Handle handle) NOEXCEPT {
+        assert(("Using handle of removed item", contains(handle)));
+        return _items[_lookup[handle.index].index];
+    }
+
+    REALLY_INLINE const T& get(const Handle handle) const NOEXCEPT {
+        assert(("Using handle of removed item", contains(handle)));
+        return _items[_lookup[handle.index].index];
+    }
+
+    // Position of the item in dense storage, changes when items are removed or swapped
+    REALLY_INLINE size_t indexOf(const Handle handle) const NOEXCEPT {
+        assert(("Using handle of removed item", contains(handle)));
+        return _lookup[handle.index].index;
+    }
+
+    REALLY_INLINE Handle handleAt(const size_t index) const NOEXCEPT {
+        assert(("Invalid index", index < _size));
+        return {_slots[index], _lookup[_slots[index]].cycle};
+    }
+
+    // Lets owners keep items partitioned, handles stay valid
+    void swapItems(const size_t a, const size_t b) {
+        assert(("Invalid index", a < _size && b < _size));
+
+        using std::swap;
+        swap(_items[a], _items[b]);
+
+        const uint32_t slotA = _slots[a];
+        place(a, _slots[b]);
+        place(b, slotA);
+    }
+
+    REALLY_INLINE T& operator[] (const size_t index) NOEXCEPT {
+        assert(("Invalid index", index < _size));
+        return _items[index];
+    }
+
+    REALLY_INLINE const T& operator[] (const size_t index) const NOEXCEPT {
+        assert(("Invalid index", index < _size));
+        return _items[index];
+    }
+
+    REALLY_INLINE T* begin() NOEXCEPT {
+        return _items;
+    }
+
+    REALLY_INLINE const T* begin() const NOEXCEPT {
+        return _items;
+    }
+
+    REALLY_INLINE T* end() NOEXCEPT {
+        return _items + _size;
+    }
+
+    REALLY_INLINE const T* end() const NOEXCEPT {
+        return _items + _size;
+    }
+
+    REALLY_INLINE bool empty() const NOEXCEPT {
+        return _size == 0;
+    }
+
+    REALLY_INLINE size_t size() const NOEXCEPT {
+        return _size;
+    }
+
+    REALLY_INLINE size_t capacity() const NOEXCEPT {
+        return _capacity;
+    }
+};
+
+}
+
+#endif // SlotMap_h__
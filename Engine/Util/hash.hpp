@@ -1,13 +1,74 @@
 #ifndef hash_h__
 #define hash_h__
 
+#include <cstdint>
 #include <cstdlib>
 
 namespace util {
 
+    // Seed of resource name hashes
+    static const uint32_t NameHashSeed = 0;
+
     // Implements Murmurhash3
     uint32_t hash(const void* data, const size_t size, const uint32_t seed);
 
+    // Same Murmurhash3 evaluated at compile time, gives the same value as hash()
+    // on little-endian platforms
+    class ConstexprHash {
+        static const uint32_t c1 = 0xcc9e2d51;
+        static const uint32_t c2 = 0x1b873593;
+
+        static constexpr uint32_t rotl(const uint32_t value, const int shift) {
+            return value << shift | value >> (32 - shift);
+        }
+
+        static constexpr uint32_t byte(const char* const data, const size_t index) {
+            return static_cast<uint8_t>(data[index]);
+        }
+
+        static constexpr uint32_t block(const char* const data) {
+            return byte(data, 0) | byte(data, 1) << 8 | byte(data, 2) << 16 | byte(data, 3) << 24;
+        }
+
+        static constexpr uint32_t mixKey(const uint32_t k1) {
+            return rotl(k1 * c1, 15) * c2;
+        }
+
+        static constexpr uint32_t body(const char* const data, const size_t blockCount, const uint32_t h1) {
+            return blockCount == 0
+                ? h1
+                : body(data + 4, blockCount - 1, rotl(h1 ^ mixKey(block(data)), 13) * 5 + 0xe6546b64);
+        }
+
+        static constexpr uint32_t tailKey(const char* const tail, const size_t size) {
+            return (size > 2 ? byte(tail, 2) << 16 : 0) ^ (size > 1 ? byte(tail, 1) << 8 : 0) ^ byte(tail, 0);
+        }
+
+        static constexpr uint32_t tail(const char* const tail, const size_t size, const uint32_t h1) {
+            return size == 0 ? h1 : h1 ^ mixKey(tailKey(tail, size));
+        }
+
+        static constexpr uint32_t xorShift(const uint32_t h, const int shift) {
+            return h ^ h >> shift;
+        }
+
+        static constexpr uint32_t finalize(const uint32_t h) {
+            return xorShift(xorShift(xorShift(h, 16) * 0x85ebca6b, 13) * 0xc2b2ae35, 16);
+        }
+
+    public:
+        static constexpr uint32_t hash(const char* const data, const size_t size, const uint32_t seed) {
+            return finalize(tail(data + (size & ~static_cast<size_t>(3)),
+                                 size & 3,
+                                 body(data, size / 4, seed)) ^ static_cast<uint32_t>(size));
+        }
+    };
+
+}
+
+// Resource name hash computed at compile time, "hero_idle"_h
+constexpr uint32_t operator"" _h(const char* const name, const size_t size) {
+    return util::ConstexprHash::hash(name, size, util::NameHashSeed);
 }
 
 #endif // hash_h__
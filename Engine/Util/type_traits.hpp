@@ -2,6 +2,7 @@
 #define type_traits_h__
 
 #include <type_traits>
+#include <utility>
 
 namespace util {
 template <typename T>
@@ -27,6 +28,19 @@ public:
     static const bool value = std::is_same<std::true_type, decltype(test<T>(0, 0))>::value;
 };
 
+// Tells allocators which can free single allocations from arenas which only rewind
+template <typename T>
+class HasFree {
+    template <class C>
+    static decltype(std::declval<C&>().free(static_cast<void*>(nullptr)), std::true_type()) test(int);
+
+    template <class C>
+    static std::false_type test(...);
+
+public:
+    static const bool value = decltype(test<T>(0))::value;
+};
+
 template <typename T>
 struct FunctionType;
 
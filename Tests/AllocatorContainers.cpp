@@ -0,0 +1,109 @@
+#include "SDL.h" // To substitute main with SDL_main
+
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "SDL_log.h"
+
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+#include "Core/Memory/SmallObjectPool.hpp"
+#include "Core/Memory/StlAllocator.hpp"
+#include "Core/Memory/TlsfAllocator.hpp"
+#include "Util/GrowableArray.hpp"
+
+// Builds std containers over StlAllocator and grows GrowableArray over arena and heap
+// allocators, checking that every element survives reallocation
+
+static const size_t HeapReserveSize = 64 * 1024 * 1024;
+static const size_t TlsfSize = 8 * 1024 * 1024;
+
+static const size_t ElementCount = 10000;
+
+static size_t failures = 0;
+
+static void check(const bool condition, const char* const what) {
+    if (!condition) {
+        SDL_Log("%s", what);
+        ++failures;
+    }
+}
+
+template <typename Allocator>
+static void testVector(Allocator& alloc, const char* const what) {
+    std::vector<size_t, StlAllocator<size_t, Allocator>> values {StlAllocator<size_t, Allocator>(alloc)};
+    for (size_t i = 0; i < ElementCount; ++i)
+        values.push_back(i);
+
+    bool intact = values.size() == ElementCount;
+    for (size_t i = 0; intact && i < ElementCount; ++i)
+        intact = values[i] == i;
+    check(intact, what);
+}
+
+// Map nodes are small enough for SmallObjectPool
+static void testMap(SmallObjectPool& pool) {
+    typedef std::pair<const size_t, size_t> Value;
+    std::map<size_t, size_t, std::less<size_t>, StlAllocator<Value, SmallObjectPool>> values {
+        std::less<size_t>(), StlAllocator<Value, SmallObjectPool>(pool)
+    };
+
+    for (size_t i = 0; i < ElementCount; ++i)
+        values[ElementCount - i] = i;
+    for (size_t i = 0; i < ElementCount; i += 2)
+        values.erase(ElementCount - i);
+
+    bool intact = values.size() == ElementCount / 2;
+    for (const Value& value : values)
+        intact = intact && value.first + value.second == ElementCount && value.second % 2;
+    check(intact, "std::map over SmallObjectPool lost elements");
+}
+
+// Starts empty, so the first add takes the minimum capacity and later ones double it
+template <typename Allocator>
+static void testGrowableArray(Allocator& alloc, const char* const what) {
+    util::GrowableArray<std::pair<size_t, size_t>, Allocator> values(alloc);
+    for (size_t i = 0; i < ElementCount; ++i) {
+        if (i % 2)
+            values.add(std::make_pair(i, 2 * i));
+        else
+            values.emplace(i, 2 * i);
+    }
+    values.pop();
+
+    bool intact = values.size() == ElementCount - 1 && values.capacity() >= values.size();
+    for (size_t i = 0; intact && i < values.size(); ++i)
+        intact = values[i].first == i && values[i].second == 2 * i;
+    check(intact, what);
+}
+
+int main(int, char**) {
+    LinearAllocator heap(HeapReserveSize, VirtualMemory::NormalPages, "Test heap");
+    SmallObjectPool::DefaultInstance smallObjectPool(heap);
+
+    {
+        ScopeStack<LinearAllocator> scope(heap, "Allocator containers");
+        TlsfAllocator* const tlsf = scope.create<TlsfAllocator>(scope, TlsfSize, "Test TLSF");
+
+        testVector(*tlsf, "std::vector over TlsfAllocator lost elements");
+        testVector(heap, "std::vector over LinearAllocator lost elements");
+        testMap(SmallObjectPool::getDefault());
+
+        testGrowableArray(heap, "GrowableArray over LinearAllocator lost elements");
+        testGrowableArray(*tlsf, "GrowableArray over TlsfAllocator lost elements");
+
+        check(tlsf->usedSize() == 0, "Containers over TlsfAllocator didn't free their memory");
+    }
+
+    SmallObjectPool::releaseThreadCache();
+
+    if (failures) {
+        SDL_Log("%u checks failed", static_cast<unsigned>(failures));
+        return 1;
+    }
+
+    SDL_Log("All containers kept their elements");
+    return 0;
+}
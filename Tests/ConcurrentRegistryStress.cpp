@@ -0,0 +1,165 @@
+#include "SDL.h" // To substitute main with SDL_main
+
+#include <atomic>
+
+#include "SDL_log.h"
+#include "SDL_thread.h"
+
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+#include "Util/ConcurrentRegistry.hpp"
+
+// Readers look up resources which stay registered the whole time while writers
+// register and remove others around them, moving entries in both copies of the table.
+// Every lookup must return the resource its name was registered with
+
+static const size_t HeapReserveSize = 64 * 1024 * 1024;
+
+static const size_t RegistrySize = 4096;
+static const size_t StableCount = 2048;
+
+static const size_t WriterCount = 3;
+static const size_t ReaderCount = 4;
+
+static const size_t NamesPerWriter = 512;
+static const size_t WriterRoundCount = 100;
+
+static const size_t ResourceCount = StableCount + WriterCount * NamesPerWriter;
+static_assert(ResourceCount <= RegistrySize, "Registry is too small");
+
+typedef util::ConcurrentRegistry<uint32_t, RegistrySize> Registry;
+
+// Murmur3 finalizer, distinct inputs give distinct name hashes
+static uint32_t nameHash(uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x85ebca6bu;
+    value ^= value >> 13;
+    value *= 0xc2b2ae35u;
+    value ^= value >> 16;
+    return value;
+}
+
+struct RegistryStress {
+    Registry& registry;
+    const uint32_t* const hashes;
+    const uint32_t* const values;
+
+    std::atomic<size_t> writerIndex;
+    std::atomic<size_t> runningWriters;
+    std::atomic<size_t> lookups;
+    std::atomic<size_t> mismatches;
+
+    RegistryStress(Registry& registry, const uint32_t* const hashes, const uint32_t* const values) :
+        registry(registry), //XXX: gcc bug prevents from using brace initialization syntax
+        hashes {hashes},
+        values {values},
+        writerIndex {0},
+        runningWriters {WriterCount},
+        lookups {0},
+        mismatches {0}
+    {}
+
+    // Writers take turns between single and bulk registration, and remove names
+    // in a different order than they were added
+    static int write(void* data) {
+        auto stress = static_cast<RegistryStress*>(data);
+        const size_t writer = stress->writerIndex.fetch_add(1, std::memory_order_relaxed);
+        const size_t first = StableCount + writer * NamesPerWriter;
+
+        const uint32_t* resources[NamesPerWriter];
+        for (size_t i = 0; i < NamesPerWriter; ++i)
+            resources[i] = &stress->values[first + i];
+
+        for (size_t round = 0; round < WriterRoundCount; ++round) {
+            if ((writer + round) % 2) {
+                stress->registry.registerResources(&stress->hashes[first], resources, NamesPerWriter);
+            } else {
+                for (size_t i = 0; i < NamesPerWriter; ++i)
+                    stress->registry.registerResource(stress->hashes[first + i], resources[i]);
+            }
+
+            for (size_t i = 1; i < NamesPerWriter; i += 2)
+                stress->registry.unregisterResource(stress->hashes[first + i]);
+            for (size_t i = 0; i < NamesPerWriter; i += 2)
+                stress->registry.unregisterResource(stress->hashes[first + i]);
+        }
+
+        stress->runningWriters.fetch_sub(1, std::memory_order_release);
+        return 0;
+    }
+
+    static int read(void* data) {
+        auto stress = static_cast<RegistryStress*>(data);
+        uint64_t seed = reinterpret_cast<uintptr_t>(&seed);
+
+        size_t lookups = 0, mismatches = 0;
+        while (stress->runningWriters.load(std::memory_order_acquire)) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            const size_t index = (seed >> 33) % StableCount;
+
+            const uint32_t* const resource = stress->registry.resourceForHandle(stress->hashes[index]);
+            if (resource != &stress->values[index] || *resource != index) {
+                if (!mismatches)
+                    SDL_Log("Resource %u was not found", static_cast<unsigned>(index));
+                ++mismatches;
+            }
+            ++lookups;
+        }
+
+        stress->lookups.fetch_add(lookups, std::memory_order_relaxed);
+        stress->mismatches.fetch_add(mismatches, std::memory_order_relaxed);
+        return 0;
+    }
+};
+
+static size_t countMissing(const Registry& registry, const uint32_t* const hashes, const uint32_t* const values) {
+    size_t missing = 0;
+    for (size_t i = 0; i < StableCount; ++i) {
+        if (registry.resourceForHandle(hashes[i]) != &values[i])
+            ++missing;
+    }
+    return missing;
+}
+
+int main(int, char**) {
+    LinearAllocator heap(HeapReserveSize, VirtualMemory::NormalPages, "Test heap");
+    ScopeStack<LinearAllocator> scope(heap, "ConcurrentRegistry stress");
+
+    uint32_t* const hashes = scope.createPODArray<uint32_t>(ResourceCount);
+    uint32_t* const values = scope.createPODArray<uint32_t>(ResourceCount);
+    for (size_t i = 0; i < ResourceCount; ++i) {
+        hashes[i] = nameHash(static_cast<uint32_t>(i));
+        values[i] = static_cast<uint32_t>(i);
+    }
+
+    Registry* const registry = scope.create<Registry>(scope);
+    for (size_t i = 0; i < StableCount; ++i)
+        registry->registerResource(hashes[i], &values[i]);
+
+    RegistryStress stress(*registry, hashes, values);
+
+    SDL_Thread* threads[ReaderCount + WriterCount];
+    for (size_t i = 0; i < ReaderCount; ++i)
+        threads[i] = SDL_CreateThread(&RegistryStress::read, "Reader", &stress);
+    for (size_t i = 0; i < WriterCount; ++i)
+        threads[ReaderCount + i] = SDL_CreateThread(&RegistryStress::write, "Writer", &stress);
+
+    for (SDL_Thread* const thread : threads)
+        SDL_WaitThread(thread, nullptr);
+
+    // once the writers are gone, both copies must agree with the stable names.
+    // A write switches the published copy, so the second pass checks the other one
+    size_t mismatches = stress.mismatches.load(std::memory_order_relaxed);
+    mismatches += countMissing(*registry, hashes, values);
+    registry->registerResource(hashes[StableCount], &values[StableCount]);
+    mismatches += countMissing(*registry, hashes, values);
+
+    if (mismatches) {
+        SDL_Log("%u of %u lookups failed",
+                static_cast<unsigned>(mismatches), static_cast<unsigned>(stress.lookups.load()));
+        return 1;
+    }
+
+    SDL_Log("All %u lookups found their resources", static_cast<unsigned>(stress.lookups.load()));
+    return 0;
+}
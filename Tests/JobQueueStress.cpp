@@ -0,0 +1,219 @@
+#include "SDL.h" // To substitute main with SDL_main
+
+#include <atomic>
+#include <new>
+
+#include "SDL_log.h"
+#include "SDL_thread.h"
+
+#include "Core/Concurrency/Job.hpp"
+#include "Core/Concurrency/JobCounter.hpp"
+#include "Core/Concurrency/JobQueue.hpp"
+#include "Core/Concurrency/MPMCQueue.hpp"
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/ScopeStack.hpp"
+#include "Core/Memory/SmallObjectPool.hpp"
+
+// Hammers MPMCQueue and JobQueue from many threads at once and checks
+// that every value is received and every job runs exactly once
+
+static const size_t HeapReserveSize = 256 * 1024 * 1024;
+
+static const size_t ProducerCount = 8;
+static const size_t ConsumerCount = 4;
+static const size_t RoundCount = 5;
+
+static const size_t ValuesPerProducer = 50000;
+static const size_t QueueCapacity = 64;
+
+// Producers add even jobs, every even job adds the next odd one from inside the queue
+static const size_t JobsPerProducer = 20000;
+
+template <typename T>
+static T* createArray(LinearAllocator& alloc, const size_t count) {
+    T* const array = static_cast<T*>(alloc.allocate(count * sizeof(T), std::alignment_of<T>::value, 0));
+    for (size_t i = 0; i < count; ++i)
+        new (&array[i]) T(0);
+    return array;
+}
+
+// Returns number of entries which were not seen exactly once
+static size_t countMismatches(const char* const what, std::atomic<uint32_t>* const seen, const size_t count) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t times = seen[i].load(std::memory_order_relaxed);
+        if (times != 1) {
+            if (!mismatches)
+                SDL_Log("%s %u was seen %u times", what, static_cast<unsigned>(i), static_cast<unsigned>(times));
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+struct QueueStress {
+    MPMCQueue<uint32_t>& queue;
+    std::atomic<uint32_t>* const seen;
+    std::atomic<size_t> producerIndex;
+    std::atomic<size_t> received;
+
+    QueueStress(MPMCQueue<uint32_t>& queue, std::atomic<uint32_t>* const seen) :
+        queue(queue), //XXX: gcc bug prevents from using brace initialization syntax
+        seen {seen},
+        producerIndex {0},
+        received {0}
+    {}
+
+    static int produce(void* data) {
+        auto stress = static_cast<QueueStress*>(data);
+        const size_t producer = stress->producerIndex.fetch_add(1, std::memory_order_relaxed);
+
+        for (size_t i = 0; i < ValuesPerProducer; ++i) {
+            const uint32_t value = static_cast<uint32_t>(producer * ValuesPerProducer + i);
+            while (!stress->queue.tryPush(value))
+                SDL_Delay(0);
+        }
+        return 0;
+    }
+
+    static int consume(void* data) {
+        auto stress = static_cast<QueueStress*>(data);
+        const size_t total = ProducerCount * ValuesPerProducer;
+
+        uint32_t value;
+        while (stress->received.load(std::memory_order_relaxed) < total) {
+            if (!stress->queue.tryPop(value)) {
+                SDL_Delay(0);
+                continue;
+            }
+
+            stress->seen[value].fetch_add(1, std::memory_order_relaxed);
+            stress->received.fetch_add(1, std::memory_order_relaxed);
+        }
+        return 0;
+    }
+};
+
+static size_t stressQueue(LinearAllocator& alloc) {
+    const LinearAllocator::RewindMarker marker = alloc.rewindMarker();
+
+    const size_t total = ProducerCount * ValuesPerProducer;
+    std::atomic<uint32_t>* const seen = createArray<std::atomic<uint32_t>>(alloc, total);
+
+    size_t mismatches = 0;
+    {
+        MPMCQueue<uint32_t> queue(alloc, QueueCapacity);
+        QueueStress stress(queue, seen);
+
+        SDL_Thread* threads[ProducerCount + ConsumerCount];
+        for (size_t i = 0; i < ConsumerCount; ++i)
+            threads[i] = SDL_CreateThread(&QueueStress::consume, "Consumer", &stress);
+        for (size_t i = 0; i < ProducerCount; ++i)
+            threads[ConsumerCount + i] = SDL_CreateThread(&QueueStress::produce, "Producer", &stress);
+
+        for (SDL_Thread* const thread : threads)
+            SDL_WaitThread(thread, nullptr);
+
+        uint32_t value;
+        if (queue.tryPop(value)) {
+            SDL_Log("MPMCQueue returned value %u after everything was received", static_cast<unsigned>(value));
+            ++mismatches;
+        }
+    }
+
+    mismatches += countMismatches("Value", seen, total);
+    alloc.rewind(marker);
+    return mismatches;
+}
+
+struct JobStress {
+    JobQueue& queue;
+    JobCounter counter;
+    std::atomic<uint32_t>* const runs;
+    std::atomic<size_t> producerIndex;
+
+    JobStress(JobQueue& queue, std::atomic<uint32_t>* const runs) :
+        queue(queue), //XXX: gcc bug prevents from using brace initialization syntax
+        counter(),
+        runs {runs},
+        producerIndex {0}
+    {}
+
+    void run(const size_t index) {
+        runs[index].fetch_add(1, std::memory_order_relaxed);
+        if (index % 2)
+            return;
+
+        // follow-up jobs are added by the worker running the job, they go to its own deque
+        JobStress* const stress = this;
+        const size_t next = index + 1;
+        queue.add(Job::create([stress, next]() {
+            stress->run(next);
+        }), counter);
+    }
+
+    static int produce(void* data) {
+        auto stress = static_cast<JobStress*>(data);
+        const size_t producer = stress->producerIndex.fetch_add(1, std::memory_order_relaxed);
+
+        for (size_t i = 0; i < JobsPerProducer; i += 2) {
+            const size_t index = producer * JobsPerProducer + i;
+            const JobQueue::Priority priority = (i / 2) % 2 ? JobQueue::Background : JobQueue::FrameCritical;
+
+            stress->queue.add(Job::create([stress, index]() {
+                stress->run(index);
+            }), stress->counter, priority);
+        }
+        return 0;
+    }
+};
+
+static size_t stressJobQueue(LinearAllocator& alloc, const size_t workerCount) {
+    const LinearAllocator::RewindMarker marker = alloc.rewindMarker();
+
+    const size_t total = ProducerCount * JobsPerProducer;
+    std::atomic<uint32_t>* const runs = createArray<std::atomic<uint32_t>>(alloc, total);
+
+    {
+        ScopeStack<LinearAllocator> scope(alloc, "JobQueue stress");
+        JobQueue* const queue = scope.create<JobQueue>(scope, workerCount);
+        JobStress stress(*queue, runs);
+
+        SDL_Thread* threads[ProducerCount];
+        for (size_t i = 0; i < ProducerCount; ++i)
+            threads[i] = SDL_CreateThread(&JobStress::produce, "Producer", &stress);
+
+        for (SDL_Thread* const thread : threads)
+            SDL_WaitThread(thread, nullptr);
+
+        queue->wait(stress.counter, JobQueue::Background);
+    }
+
+    const size_t mismatches = countMismatches("Job", runs, total);
+    alloc.rewind(marker);
+    return mismatches;
+}
+
+int main(int, char**) {
+    LinearAllocator heap(HeapReserveSize, VirtualMemory::NormalPages, "Test heap");
+    SmallObjectPool::DefaultInstance smallObjectPool(heap);
+
+    size_t failures = 0;
+    for (size_t round = 0; round < RoundCount; ++round) {
+        failures += stressQueue(heap) != 0;
+
+        // single worker leaves most of the stealing to the producers helping to drain full lanes
+        failures += stressJobQueue(heap, 1) != 0;
+        failures += stressJobQueue(heap, 0) != 0;
+    }
+
+    SmallObjectPool::releaseThreadCache();
+
+    if (failures) {
+        SDL_Log("%u of %u runs failed", static_cast<unsigned>(failures), static_cast<unsigned>(3 * RoundCount));
+        return 1;
+    }
+
+    SDL_Log("All jobs and values were seen exactly once");
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include "SDL.h" // To substitute main with SDL_main
+
+#include "SDL_log.h"
+
+#include "Util/hash.hpp"
+
+// Checks that resource name hashes computed at compile time match util::hash,
+// so "name"_h finds what was registered under the hash of a name read at runtime
+
+// Reference MurmurHash3 x86_32 values with seed 0
+static_assert(""_h == 0, "Hash of an empty name is wrong");
+static_assert("hello"_h == 0x248bfa47, "Hash of a one block name with a tail is wrong");
+static_assert("Hello, world!"_h == 0xc0363e43, "Hash of a three block name with a tail is wrong");
+static_assert("The quick brown fox jumps over the lazy dog"_h == 0x2e4ff723, "Hash of a long name is wrong");
+
+static const size_t MaxNameLength = 64;
+
+int main(int, char**) {
+    char name[MaxNameLength];
+
+    size_t failures = 0;
+    for (size_t length = 0; length < MaxNameLength; ++length) {
+        for (size_t i = 0; i < length; ++i)
+            name[i] = static_cast<char>('a' + (i * 7 + length) % 26);
+
+        // every tail length and block count, with bytes above 0x7F too
+        if (length)
+            name[length - 1] = static_cast<char>(0x80 + length);
+
+        const uint32_t expected = util::hash(name, length, util::NameHashSeed);
+        const uint32_t actual = util::ConstexprHash::hash(name, length, util::NameHashSeed);
+        if (actual != expected) {
+            SDL_Log("Name of %u characters hashes to %08x instead of %08x",
+                    static_cast<unsigned>(length), static_cast<unsigned>(actual), static_cast<unsigned>(expected));
+            ++failures;
+        }
+    }
+
+    if (failures) {
+        SDL_Log("%u of %u names hashed differently", static_cast<unsigned>(failures), static_cast<unsigned>(MaxNameLength));
+        return 1;
+    }
+
+    SDL_Log("Compile time and runtime hashes match");
+    return 0;
+}
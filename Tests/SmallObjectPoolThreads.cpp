@@ -0,0 +1,117 @@
+#include "SDL.h" // To substitute main with SDL_main
+
+#include <atomic>
+#include <new>
+#include <thread>
+
+#include "SDL_log.h"
+#include "SDL_thread.h"
+
+#include "Core/Memory/LinearAllocator.hpp"
+#include "Core/Memory/SmallObjectPool.hpp"
+
+// Threads fill their caches without calling releaseThreadCache. Chunks of threads which
+// exit have to go back to the pool, chunks of threads which outlive the pool are drained
+// by its destructor, and a new pool placed at the same address must not reuse their caches
+
+static const size_t HeapReserveSize = 64 * 1024 * 1024;
+static const size_t PoolSize = 2 * 1024 * 1024;
+
+static const size_t WorkerCount = 4;
+static const size_t ObjectCount = 1000;
+
+static size_t failures = 0;
+
+static void check(const bool condition, const char* const what) {
+    if (!condition) {
+        SDL_Log("%s", what);
+        ++failures;
+    }
+}
+
+// Frees in a different order than it allocates, so chunks of every size end up cached
+static void churn(SmallObjectPool& pool) {
+    void* objects[ObjectCount];
+    for (size_t i = 0; i < ObjectCount; ++i)
+        objects[i] = pool.allocate(i % 128 + 1, 1, 0);
+    for (size_t i = 1; i < ObjectCount; i += 2)
+        pool.free(objects[i]);
+    for (size_t i = 0; i < ObjectCount; i += 2)
+        pool.free(objects[i]);
+}
+
+static int exitingWorker(void* data) {
+    churn(*static_cast<SmallObjectPool*>(data));
+    return 0;
+}
+
+struct LingeringWorker {
+    SmallObjectPool* pool;
+    std::atomic<int> step;
+
+    void waitFor(const int expected) {
+        while (step.load(std::memory_order_acquire) != expected)
+            std::this_thread::yield();
+    }
+
+    void advance() {
+        step.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    // Keeps its cache over the pool which is destroyed and created again in its place
+    static int run(void* data) {
+        auto worker = static_cast<LingeringWorker*>(data);
+
+        churn(*worker->pool);
+        worker->advance();
+
+        worker->waitFor(2);
+        churn(*worker->pool);
+        worker->advance();
+
+        worker->waitFor(4);
+        return 0;
+    }
+};
+
+int main(int, char**) {
+    LinearAllocator heap(HeapReserveSize, VirtualMemory::NormalPages, "Test heap");
+
+    void* const memory = heap.allocate(sizeof(SmallObjectPool), std::alignment_of<SmallObjectPool>::value, 0);
+    SmallObjectPool* pool = new (memory) SmallObjectPool(heap, PoolSize, "Test pool");
+
+    SDL_Thread* workers[WorkerCount];
+    for (SDL_Thread*& thread : workers)
+        thread = SDL_CreateThread(&exitingWorker, "Worker", pool);
+    for (SDL_Thread* const thread : workers)
+        SDL_WaitThread(thread, nullptr);
+
+    pool->trim();
+    check(pool->usedSize() == 0, "Caches of exited threads were not returned");
+
+    LingeringWorker lingering;
+    lingering.pool = pool;
+    lingering.step.store(0, std::memory_order_relaxed);
+
+    SDL_Thread* const thread = SDL_CreateThread(&LingeringWorker::run, "Lingering worker", &lingering);
+    lingering.waitFor(1);
+
+    // leaks are asserted by the destructor
+    pool->~SmallObjectPool();
+    pool = new (memory) SmallObjectPool(heap, PoolSize, "Test pool");
+    lingering.advance();
+
+    lingering.waitFor(3);
+    pool->~SmallObjectPool();
+    lingering.advance();
+
+    SDL_WaitThread(thread, nullptr);
+
+    if (failures) {
+        SDL_Log("%u checks failed", static_cast<unsigned>(failures));
+        return 1;
+    }
+
+    SDL_Log("All thread caches went back to their pools");
+    return 0;
+}